@@ -35,6 +35,8 @@ static Rboolean rollToNearest=FALSE;
 #define XIND(i) (xo ? xo[(i)]-1 : i)
 
 void bmerge_r(int xlowIn, int xuppIn, int ilowIn, int iuppIn, int col, int thisgrp, int lowmax, int uppmax);
+static bool mergewalk_ok(void);
+static void mergewalk(int xN, int iN);
 
 SEXP bmerge(SEXP idt, SEXP xdt, SEXP icolsArg, SEXP xcolsArg, SEXP xoArg, SEXP rollarg, SEXP rollendsArg, SEXP nomatchArg, SEXP multArg, SEXP opArg, SEXP nqgrpArg, SEXP nqmaxgrpArg) {
   const bool verbose = GetVerbose();
@@ -201,12 +203,18 @@ SEXP bmerge(SEXP idt, SEXP xdt, SEXP icolsArg, SEXP xcolsArg, SEXP xoArg, SEXP r
   if (iN) {
     if (verbose)
       tic0 = omp_get_wtime();
-    // embarrassingly parallel if we've storage space for nqmaxgrp*iN
-    for (int kk=0; kk<nqmaxgrp; kk++) {
-      bmerge_r(-1,xN,-1,iN,scols,kk+1,1,1);
+    if (mergewalk_ok()) {
+      mergewalk(xN, iN);
+      if (verbose)
+        Rprintf(_("bmerge: merge-walk of sorted i and x took %.3fs\n"), omp_get_wtime()-tic0);
+    } else {
+      // embarrassingly parallel if we've storage space for nqmaxgrp*iN
+      for (int kk=0; kk<nqmaxgrp; kk++) {
+        bmerge_r(-1,xN,-1,iN,scols,kk+1,1,1);
+      }
+      if (verbose)
+        Rprintf(_("bmerge: looping bmerge_r took %.3fs\n"), omp_get_wtime()-tic0);
     }
-    if (verbose)
-      Rprintf(_("bmerge: looping bmerge_r took %.3fs\n"), omp_get_wtime()-tic0);
   }
   ctr += iN;
   if (nqmaxgrp > 1 && mult == ALL) {
@@ -490,3 +498,123 @@ void bmerge_r(int xlowIn, int xuppIn, int ilowIn, int iuppIn, int col, int thisg
   default : break;  // one of 5 valid cases checked up front
   }
 }
+
+/*
+Merge-walk for rolling joins when both i and x are already sorted on the join columns (o and xo both NULL), e.g. as-of
+joins of tick data where both tables are keyed. Rather than a binary search per i group, one pointer per bound is moved
+forwards through x as i advances, galloping (doubling steps, then halving) so that sparse i is still cheap. The result
+is the same as bmerge_r's, including roll distance, rollends, roll='nearest' and mult, and is written to the same
+retFirst/retLength. Only equi joins (op all EQ) on non-character columns; others go through bmerge_r.
+*/
+static bool mergewalk_ok(void) {
+  if (roll==0.0 || o || xo || nqmaxgrp!=1) return false;
+  for (int col=0; col<ncol; ++col) {
+    if (op[col]!=EQ || TYPEOF(xdtVec[xcols[col]-1])==STRSXP) return false;
+  }
+  return true;
+}
+
+// join columns as mwcmp compares them, resolved once per mergewalk rather than on every comparison
+typedef struct {
+  enum {MW_INT, MW_INT64, MW_DOUBLE} kind;
+  const void *x, *i;
+} mwcol_t;
+
+// sign of x row xr minus i row ir over columns [0, nc), in the order bmerge_r compares them
+static int mwcmp(const mwcol_t *mc, const int xr, const int ir, const int nc) {
+  for (int col=0; col<nc; ++col) {
+    int c;
+    switch (mc[col].kind) {
+    case MW_INT: {
+      const int xv = ((const int *)mc[col].x)[xr], iv = ((const int *)mc[col].i)[ir];
+      c = (xv>iv) - (xv<iv);
+    } break;
+    case MW_INT64: {
+      const int64_t xv = ((const int64_t *)mc[col].x)[xr], iv = ((const int64_t *)mc[col].i)[ir];
+      c = (xv>iv) - (xv<iv);
+    } break;
+    default: { // MW_DOUBLE
+      const uint64_t xv = dtwiddle(((const double *)mc[col].x)[xr]), iv = dtwiddle(((const double *)mc[col].i)[ir]);
+      c = (xv>iv) - (xv<iv);
+    }
+    }
+    if (c) return c;
+  }
+  return 0;
+}
+
+// first x row >= from whose first nc columns compare >= i row ir (> when strict), or xN
+static int gallop(const mwcol_t *mc, int from, const int xN, const int ir, const int nc, const bool strict) {
+  const int t = strict ? 0 : -1;  // advance while mwcmp <= t
+  if (from>=xN || mwcmp(mc, from, ir, nc) > t) return from;
+  int step = 1, low = from;  // low always satisfies mwcmp <= t
+  while (low+step < xN && mwcmp(mc, low+step, ir, nc) <= t) { low += step; step *= 2; }
+  int upp = MIN(low+step, xN);
+  while (low < upp-1) {
+    const int mid = low + (upp-low)/2;
+    if (mwcmp(mc, mid, ir, nc) <= t) low = mid; else upp = mid;
+  }
+  return upp;
+}
+
+static void mergewalk(const int xN, const int iN) {
+  const int last = ncol-1;
+  const SEXP xc = xdtVec[xcols[last]-1], ic = idtVec[icols[last]-1];
+  const bool isInt64 = INHERITS(xc, char_integer64), isInt = TYPEOF(xc)!=REALSXP;
+  mwcol_t *mc = (mwcol_t *)R_alloc(ncol, sizeof(*mc));
+  for (int col=0; col<ncol; ++col) {
+    const SEXP xcc = xdtVec[xcols[col]-1], icc = idtVec[icols[col]-1];
+    // LGLSXP, INTSXP or REALSXP, checked in mergewalk_ok
+    mc[col] = TYPEOF(xcc)!=REALSXP ? (mwcol_t){ .kind=MW_INT, .x=INTEGER_RO(xcc), .i=INTEGER_RO(icc) } :
+              (mwcol_t){ .kind=INHERITS(xcc, char_integer64) ? MW_INT64 : MW_DOUBLE, .x=REAL_RO(xcc), .i=REAL_RO(icc) };
+  }
+  int a=0, b=last>0 ? 0 : xN, L=0, U=0;  // x rows [a,b) match i's prefix (all but last column) and [L,U) match all columns
+  for (int ir=0; ir<iN; ++ir) {
+    if (last>0) {
+      a = gallop(mc, a, xN, ir, last, false);
+      b = gallop(mc, MAX(a, b), xN, ir, last, true);
+      if (a==b) { L = U = a; continue; }  // no match on prefix columns: no roll either, as bmerge_r
+    }
+    L = gallop(mc, MAX(a, L), b, ir, ncol, false);
+    U = gallop(mc, MAX(L, U), b, ir, ncol, true);
+    const bool before = L>a, after = U<b;  // x rows in the prefix group before/after i's value in the last column
+    bool rollLow=false, rollUpp=false;
+    if (L==U) {
+      #define ROLL(TYPE, LOWDIST, UPPDIST)                                                                                \
+        if (rollToNearest) {                                                                                            \
+          if (before && after) { if ((LOWDIST) <= (UPPDIST)) rollLow=true; else rollUpp=true; }                         \
+          else if (!after && rollends[1]) rollLow=true;                                                                 \
+          else if (!before && rollends[0]) rollUpp=true;                                                                \
+        } else {                                                                                                        \
+          if (((roll>0.0 && before && (after || rollends[1])) || (roll<0.0 && !after && rollends[1])) &&                \
+              (isinf(rollabs) || ((LOWDIST)-(TYPE)rollabs <= (TYPE)1e-6)))                                              \
+            rollLow=true;                                                                                               \
+          else if (((roll<0.0 && after && (before || rollends[0])) || (roll>0.0 && !before && rollends[0])) &&          \
+              (isinf(rollabs) || ((UPPDIST)-(TYPE)rollabs <= (TYPE)1e-6)))                                              \
+            rollUpp=true;                                                                                               \
+        }
+      // distances are only evaluated (by || short-circuit above) when the row they refer to exists
+      if (isInt) {
+        const int *xcv = INTEGER(xc), ival = INTEGER(ic)[ir];
+        ROLL(int, ival-xcv[L-1], xcv[U]-ival)
+      } else if (isInt64) {
+        const int64_t *xcv = (const int64_t *)REAL(xc), ival = ((const int64_t *)REAL(ic))[ir];
+        ROLL(int64_t, ival-xcv[L-1], xcv[U]-ival)
+      } else {
+        const double *xcv = REAL(xc), ival = REAL(ic)[ir];
+        ROLL(double, ival-xcv[L-1], xcv[U]-ival)
+      }
+      #undef ROLL
+      if (!rollLow && !rollUpp) continue;  // nomatch, as initialised
+    }
+    const int len = U-L+rollLow+rollUpp;
+    if (len>1) {
+      if (mult==ALL)
+        allLen1[0] = FALSE;
+      else if (mult==ERR)
+        error("mult='error' and multiple matches during merge");
+    }
+    retFirst[ir] = (mult!=LAST) ? L+1-rollLow : U+rollUpp;  // 1-based, as bmerge_r's xlow+2-rollLow and xupp+rollUpp
+    retLength[ir] = (mult==ALL) ? len : 1;
+  }
+}
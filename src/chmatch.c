@@ -1,5 +1,9 @@
 #include "data.table.h"
 
+// chmatch and chin of larger inputs use a hash table keyed by CHARSXP address, which leaves TRUELENGTH alone so that x is
+// matched in parallel. Below this size stamping TRUELENGTH is faster as there is no table to allocate
+#define CHMATCH_HASH_MIN 65536
+
 static SEXP chmatchMain(SEXP x, SEXP table, int nomatch, bool chin, bool chmatchdup) {
   if (!isString(table) && !isNull(table))
     error(_("table is type '%s' (must be 'character' or NULL)"), type2char(TYPEOF(table)));
@@ -55,6 +59,23 @@ static SEXP chmatchMain(SEXP x, SEXP table, int nomatch, bool chin, bool chmatch
     UNPROTECT(nprotect);
     return ans;
   }
+  if (!chmatchdup && (int64_t)xlen + tablelen > CHMATCH_HASH_MIN) {
+    // CHARSXP in R's global cache are unique by bytes and encoding, and both x and table are UTF-8 now, so the same
+    // string has the same address
+    const void *vmax = vmaxget();
+    hashtab *marks = hash_create(tablelen);
+    for (int i=0; i<tablelen; ++i) {
+      if (!hash_lookup(marks, td[i], 0)) hash_set(marks, td[i], i+1);  // first time seen this string in table
+    }
+    #pragma omp parallel for num_threads(getDTthreads(xlen, true))
+    for (int i=0; i<xlen; ++i) {
+      const int m = (int)hash_lookup(marks, xd[i], 0);
+      ansd[i] = chin ? m>0 : (m ? m : nomatch);
+    }
+    vmaxset(vmax);  // release the table now rather than when .Call returns, since chmatch may be called many times from C
+    UNPROTECT(nprotect);
+    return ans;
+  }
   // else xlen>1; nprotect is const above since no more R allocations should occur after this point
   savetl_init();
   for (int i=0; i<xlen; i++) {
@@ -150,6 +150,12 @@ void writeNA(SEXP v, const int from, const int n, const bool listNA);
 void savetl_init(void), savetl(SEXP s), savetl_end(void);
 int checkOverAlloc(SEXP x);
 
+// hash.c
+typedef struct hash_tab hashtab;
+hashtab *hash_create(size_t n);
+void hash_set(hashtab *h, SEXP key, R_xlen_t value);
+R_xlen_t hash_lookup(const hashtab *h, SEXP key, R_xlen_t ifnotfound);
+
 // forder.c
 int StrCmp(SEXP x, SEXP y);
 uint64_t dtwiddle(double x);
@@ -176,6 +182,11 @@ SEXP vecseq(SEXP x, SEXP len, SEXP clamp);
 // uniqlist.c
 SEXP uniqlist(SEXP l, SEXP order);
 SEXP uniqlengths(SEXP x, SEXP n);
+#define HLL_P 12                      // HyperLogLog precision for uniqueN(approx=TRUE)
+#define HLL_REGISTERS (1<<HLL_P)      // standard error about 1.04/sqrt(HLL_REGISTERS), i.e. 1.6%
+uint64_t uniqueNdkey(double x);
+void hlladd(uint8_t *reg, uint64_t key);
+double hllestimate(const uint8_t *reg);
 
 // chmatch.c
 SEXP chmatch(SEXP x, SEXP table, int nomatch);
@@ -212,6 +223,7 @@ SEXP bmerge(SEXP idt, SEXP xdt, SEXP icolsArg, SEXP xcolsArg,
 double dquickselect(double *x, int n);
 double iquickselect(int *x, int n);
 double i64quickselect(int64_t *x, int n);
+double dquickselectk(double *x, int n, int l, int k);
 
 // fread.c
 double wallclock(void);
@@ -233,10 +245,18 @@ typedef enum { // adding rolling functions here and in frollfunR in frollR.c
   PROD = 4,
   MEDIAN = 5,
   VAR = 6,
-  SD = 7
+  SD = 7,
+  QUANTILE = 8,
+  SKEW = 9,
+  KURT = 10,
+  RANK = 11,
+  UNIQUEN = 12,
+  EWMA = 13,      // exponentially weighted ones have no window, computed by fewmfun in fewm.c rather than routed by frollfun
+  EWMVAR = 14
 } rollfun_t;
 // froll.c
-void frollfun(rollfun_t rfun, unsigned int algo, const double *x, uint64_t nx, ans_t *ans, int k, int align, double fill, bool narm, int hasnf, bool verbose, bool par);
+void frollfun(rollfun_t rfun, unsigned int algo, const double *x, uint64_t nx, ans_t *ans, int k, int align, double fill, bool narm, int hasnf, double p, bool verbose, bool par);
+void frollfunGrouped(rollfun_t rfun, unsigned int algo, const void *x, int xtype, ans_t *ans, const int *gs, const int *gl, int ngrp, int k, const int *ka, int align, double fill, int64_t i64fill, bool narm, int hasnf, double p);
 void frollmeanFast(const double *x, uint64_t nx, ans_t *ans, int k, double fill, bool narm, int hasnf, bool verbose);
 void frollmeanExact(const double *x, uint64_t nx, ans_t *ans, int k, double fill, bool narm, int hasnf, bool verbose);
 void frollsumFast(const double *x, uint64_t nx, ans_t *ans, int k, double fill, bool narm, int hasnf, bool verbose);
@@ -253,16 +273,17 @@ void frollvarFast(const double *x, uint64_t nx, ans_t *ans, int k, double fill,
 void frollvarExact(const double *x, uint64_t nx, ans_t *ans, int k, double fill, bool narm, int hasnf, bool verbose);
 void frollsdFast(const double *x, uint64_t nx, ans_t *ans, int k, double fill, bool narm, int hasnf, bool verbose);
 void frollsdExact(const double *x, uint64_t nx, ans_t *ans, int k, double fill, bool narm, int hasnf, bool verbose);
+void frollindexwidth(const double *idx, uint64_t nx, double n, bool left, bool partial, int *k);
 
 // frolladaptive.c
-void frolladaptivefun(rollfun_t rfun, unsigned int algo, const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose);
+void frolladaptivefun(rollfun_t rfun, unsigned int algo, const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, double p, bool verbose);
 void frolladaptivemeanFast(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose);
 void frolladaptivemeanExact(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose);
 void frolladaptivesumFast(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose);
 void frolladaptivesumExact(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose);
-//void frolladaptivemaxFast(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose); // does not exists as of now
+void frolladaptivemaxFast(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose);
 void frolladaptivemaxExact(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose);
-//void frolladaptiveminFast(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose); // does not exists as of now
+void frolladaptiveminFast(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose);
 void frolladaptiveminExact(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose);
 //void frolladaptiveprodFast(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose); // does not exists as of now
 void frolladaptiveprodExact(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose);
@@ -273,9 +294,27 @@ void frolladaptivevarExact(const double *x, uint64_t nx, ans_t *ans, const int *
 //void frolladaptivesdFast(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose); // does not exists as of now
 void frolladaptivesdExact(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose);
 
+// frollint.c
+void frollfunInt(rollfun_t rfun, unsigned int algo, const void *x, bool int64, uint64_t nx, ans_t *ans, int k, const int *ka, int align, double dfill, int64_t i64fill, bool narm, int hasnf, bool verbose, bool par);
+
+// frollstat.c
+void frollfunStat(rollfun_t rfun, unsigned int algo, const double *x, uint64_t nx, ans_t *ans, int k, const int *ka, int off, double p, double fill, bool narm, int hasnf, bool verbose, bool par);
+void frollstatExact(rollfun_t rfun, const double *x, uint64_t nx, ans_t *ans, int k, const int *ka, int off, double p, double fill, bool narm, int hasnf, bool verbose);
+
+// fcum.c
+int firststart(const int *gs, int ngrp, int64_t p);
+void fcumfun(rollfun_t rfun, const double *x, uint64_t nx, ans_t *ans, const int *o, const int *gs, int ngrp, bool narm, bool verbose);
+SEXP fcumR(SEXP fun, SEXP xobj, SEXP narm, SEXP o, SEXP starts);
+
+// fewm.c
+void fewmfun(rollfun_t rfun, const double *x, uint64_t nx, ans_t *ans, double alpha, bool adjust, bool bias, const int *o, const int *gs, int ngrp, bool narm, int hasnf, int nc, bool verbose);
+SEXP fewmR(SEXP fun, SEXP xobj, SEXP alpha, SEXP adjust, SEXP bias, SEXP narm, SEXP hasnf, SEXP o, SEXP starts);
+
 // frollR.c
-SEXP frollfunR(SEXP fun, SEXP xobj, SEXP kobj, SEXP fill, SEXP algo, SEXP align, SEXP narm, SEXP hasnf, SEXP adaptive);
+SEXP coerceX(SEXP obj, bool intok);
+SEXP frollfunR(SEXP fun, SEXP xobj, SEXP kobj, SEXP fill, SEXP algo, SEXP align, SEXP narm, SEXP hasnf, SEXP adaptive, SEXP p, SEXP grp);
 SEXP frolladapt(SEXP xobj, SEXP kobj, SEXP partial);
+SEXP frollindex(SEXP index, SEXP nobj, SEXP align, SEXP partial);
 
 // frollapply.c
 SEXP memcpyVector(SEXP dest, SEXP src, SEXP offset, SEXP size);
@@ -285,9 +324,11 @@ SEXP memcpyDTadaptive(SEXP dest, SEXP src, SEXP offset, SEXP size);
 SEXP setgrowable(SEXP x);
 
 // nafill.c
-void nafillDouble(double *x, uint_fast64_t nx, unsigned int type, double fill, bool nan_is_na, ans_t *ans, bool verbose);
-void nafillInteger(int32_t *x, uint_fast64_t nx, unsigned int type, int32_t fill, ans_t *ans, bool verbose);
-SEXP nafillR(SEXP obj, SEXP type, SEXP fill, SEXP nan_is_na_arg, SEXP inplace, SEXP cols);
+void nafillDouble(double *x, uint_fast64_t nx, unsigned int type, double fill, bool nan_is_na, ans_t *ans, const int *o, const int *gs, int ngrp, int nc, bool verbose);
+void nafillInteger(int32_t *x, uint_fast64_t nx, unsigned int type, int32_t fill, ans_t *ans, const int *o, const int *gs, int ngrp, int nc, bool verbose);
+void nafillInteger64(int64_t *x, uint_fast64_t nx, unsigned int type, int64_t fill, ans_t *ans, const int *o, const int *gs, int ngrp, int nc, bool verbose);
+void nafillString(SEXP x, unsigned int type, SEXP fill, SEXP ansx, ans_t *ans, const int *o, const int *gs, int ngrp, bool verbose);
+SEXP nafillR(SEXP obj, SEXP type, SEXP fill, SEXP nan_is_na_arg, SEXP inplace, SEXP cols, SEXP o, SEXP starts);
 
 // between.c
 SEXP between(SEXP x, SEXP lower, SEXP upper, SEXP incbounds, SEXP NAbounds, SEXP check);
@@ -369,7 +410,7 @@ SEXP setS4elt(SEXP, SEXP, SEXP);
 SEXP address(SEXP);
 SEXP expandAltRep(SEXP);
 SEXP fmelt(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
-SEXP fcast(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+SEXP fcast(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 SEXP issorted(SEXP, SEXP);
 SEXP gforce(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 SEXP gsum(SEXP, SEXP);
@@ -384,8 +425,10 @@ SEXP convertNegAndZeroIdx(SEXP, SEXP, SEXP, SEXP);
 SEXP frank(SEXP, SEXP, SEXP, SEXP);
 SEXP lookup(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 SEXP overlaps(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+SEXP overlapsIndex(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+SEXP nqIntervalIndex(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 SEXP whichwrapper(SEXP, SEXP);
-SEXP shift(SEXP, SEXP, SEXP, SEXP);
+SEXP shift(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 SEXP transpose(SEXP, SEXP, SEXP, SEXP, SEXP);
 SEXP anyNA(SEXP, SEXP);
 SEXP setlevels(SEXP, SEXP, SEXP);
@@ -402,6 +445,13 @@ SEXP gvar(SEXP, SEXP);
 SEXP gsd(SEXP, SEXP);
 SEXP gprod(SEXP, SEXP);
 SEXP gshift(SEXP, SEXP, SEXP, SEXP);
+SEXP growwise(SEXP);
+SEXP gquantile(SEXP, SEXP, SEXP);
+SEXP gmad(SEXP, SEXP, SEXP);
+SEXP guniqueN(SEXP, SEXP, SEXP);
+SEXP gfroll(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+SEXP gfcum(SEXP, SEXP, SEXP);
+SEXP gnafill(SEXP, SEXP, SEXP, SEXP);
 SEXP nestedid(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 SEXP setDTthreads(SEXP, SEXP, SEXP, SEXP);
 SEXP getDTthreads_R(SEXP);
@@ -411,6 +461,8 @@ SEXP fsort(SEXP, SEXP);
 SEXP inrange(SEXP, SEXP, SEXP, SEXP);
 SEXP hasOpenMP(void);
 SEXP uniqueNlogical(SEXP, SEXP);
+SEXP uniqueNapprox(SEXP, SEXP);
+SEXP hashuniq(SEXP, SEXP, SEXP, SEXP, SEXP);
 SEXP dllVersion(void);
 SEXP initLastUpdated(SEXP);
 SEXP allNAR(SEXP);
@@ -4,9 +4,156 @@
 // raise(SIGINT);
 
 // TO DO: margins
-SEXP fcast(SEXP lhs, SEXP val, SEXP nrowArg, SEXP ncolArg, SEXP idxArg, SEXP fill, SEXP fill_d, SEXP is_agg, SEXP some_fillArg) {
+
+// fun.aggregate computed by fcast itself straight into the cells of the result, rather than by a grouped query beforehand; see dcast.data.table
+enum { CAST_SUM, CAST_MEAN, CAST_MIN, CAST_MAX, CAST_LENGTH, CAST_FIRST, CAST_LAST, CAST_NFUN };
+static const char *castfunnames[CAST_NFUN] = {"sum", "mean", "min", "max", "length", "first", "last"};
+
+static SEXPTYPE castaggtype(int fun, SEXPTYPE type) {
+  switch(fun) {
+  case CAST_MEAN : return REALSXP;
+  case CAST_LENGTH : return INTSXP;
+  case CAST_SUM : case CAST_MIN : case CAST_MAX : return type==REALSXP ? REALSXP : INTSXP; // like base R, logical is summed as integer
+  default : return type; // CAST_FIRST, CAST_LAST
+  }
+}
+
+/* aggregate of x in rows o[from..to) (1-based, in their original order) as base R would compute it on those rows
+ *   sum of integer is accumulated in 64 bits and is NA (overflow) when it does not fit, sum and mean of double are accumulated in long double
+ *   and mean is refined by the mean of residuals, min and max let NA trump NaN, an aggregate of no non-missing values is NaN for mean and
+ *   +-Inf for min and max (noneleft)
+ */
+static double castaggdouble(int fun, const double *x, const int *o, int from, int to, bool narm, bool *noneleft) {
+  long double s = 0.0;
+  int64_t n = 0;
+  switch(fun) {
+  case CAST_SUM :
+    for (int p=from; p<to; ++p) {
+      const double v = x[o[p]-1];
+      if (!narm || !ISNAN(v)) s += v;
+    }
+    return (double)s;
+  case CAST_MEAN :
+    for (int p=from; p<to; ++p) {
+      const double v = x[o[p]-1];
+      if (!narm || !ISNAN(v)) { s += v; n++; }
+    }
+    s /= n;
+    if (R_FINITE((double)s)) {
+      long double t = 0.0;
+      for (int p=from; p<to; ++p) {
+        const double v = x[o[p]-1];
+        if (!narm || !ISNAN(v)) t += (v - s);
+      }
+      s += t/n;
+    }
+    return (double)s;
+  default : { // CAST_MIN, CAST_MAX
+    const bool min = fun==CAST_MIN;
+    double m = min ? R_PosInf : R_NegInf;
+    bool updated = false;
+    for (int p=from; p<to; ++p) {
+      const double v = x[o[p]-1];
+      if (ISNAN(v)) {
+        if (!narm) {
+          if (!ISNA(m)) m = v; // so any NA trumps all NaNs
+          updated = true;
+        }
+      } else if (!updated || (min ? v<m : v>m)) {
+        m = v;
+        updated = true;
+      }
+    }
+    if (!updated) *noneleft = true;
+    return m;
+  }
+  }
+}
+
+static int castaggint(int fun, const int *x, const int *o, int from, int to, bool narm, bool *overflow) {
+  int64_t s = 0;
+  switch(fun) {
+  case CAST_LENGTH :
+    return to-from;
+  case CAST_SUM :
+    for (int p=from; p<to; ++p) {
+      const int v = x[o[p]-1];
+      if (v==NA_INTEGER) {
+        if (!narm) return NA_INTEGER;
+      } else s += v;
+    }
+    if (s>INT_MAX || s<=NA_INTEGER) {
+      *overflow = true;
+      return NA_INTEGER;
+    }
+    return (int)s;
+  default : { // CAST_MIN, CAST_MAX; not with na.rm=TRUE where a cell of only NA would be a double Inf
+    const bool min = fun==CAST_MIN;
+    int m = x[o[from]-1];
+    for (int p=from; p<to; ++p) {
+      const int v = x[o[p]-1];
+      if (v==NA_INTEGER) return NA_INTEGER;
+      if (min ? v<m : v>m) m = v;
+    }
+    return m;
+  }
+  }
+}
+
+static double castaggmeanint(const int *x, const int *o, int from, int to, bool narm) {
+  long double s = 0.0;
+  int64_t n = 0;
+  for (int p=from; p<to; ++p) {
+    const int v = x[o[p]-1];
+    if (v==NA_INTEGER) {
+      if (!narm) return NA_REAL;
+    } else {
+      s += v;
+      n++;
+    }
+  }
+  return (double)(s/n);
+}
+
+/* map is the list of the 1-based row (lhs group) and column (rhs group) in the result of each row of val
+ * without fun.aggregate (fun is NULL) the cells are all distinct, so the values are scattered straight into the result rather than via an index
+ *   of every cell of the cross join of rows and columns
+ * with fun.aggregate, fun is the name of the function of each column of val, and o and starts group the rows of val by cell; each cell is then
+ *   aggregated from its rows straight into the result, in parallel over cells
+ */
+SEXP fcast(SEXP lhs, SEXP val, SEXP nrowArg, SEXP ncolArg, SEXP mapArg, SEXP fill, SEXP fill_d, SEXP is_agg, SEXP some_fillArg, SEXP funArg, SEXP narmArg, SEXP oArg, SEXP startsArg) {
   int nrows=INTEGER(nrowArg)[0], ncols=INTEGER(ncolArg)[0];
-  int nlhs=length(lhs), nval=length(val), *idx = INTEGER(idxArg);
+  int nlhs=length(lhs), nval=length(val);
+  if (!isNewList(mapArg) || length(mapArg)!=2 || !isInteger(VECTOR_ELT(mapArg, 0)) || !isInteger(VECTOR_ELT(mapArg, 1)) || length(VECTOR_ELT(mapArg, 0))!=length(VECTOR_ELT(mapArg, 1)))
+    internal_error(__func__, "map is not a list of two integer vectors of the same length"); // # nocov
+  const int n = length(VECTOR_ELT(mapArg, 0));
+  const int *rowmap = INTEGER(VECTOR_ELT(mapArg, 0)), *colmap = INTEGER(VECTOR_ELT(mapArg, 1));
+  for (int r=0; r<n; ++r) {
+    if (rowmap[r]<1 || rowmap[r]>nrows || colmap[r]<1 || colmap[r]>ncols)
+      internal_error(__func__, "row %d of value is mapped to cell [%d,%d] outside the result of %d rows and %d columns", r+1, rowmap[r], colmap[r], nrows, ncols); // # nocov
+  }
+  const bool agg = !isNull(funArg);
+  int *funs = NULL, ngrp = 0;
+  const int *o = NULL, *starts = NULL;
+  if (agg) {
+    if (!isString(funArg) || length(funArg)!=nval || !isLogical(narmArg) || length(narmArg)!=nval || !isInteger(oArg) || !isInteger(startsArg))
+      internal_error(__func__, "fun, na.rm, o or starts are not valid"); // # nocov
+    funs = (int *)R_alloc(nval, sizeof(*funs));
+    for (int i=0; i<nval; ++i) {
+      funs[i] = 0;
+      while (funs[i]<CAST_NFUN && strcmp(CHAR(STRING_ELT(funArg, i)), castfunnames[funs[i]])) funs[i]++;
+      if (funs[i]==CAST_NFUN) internal_error(__func__, "fun '%s' is not supported", CHAR(STRING_ELT(funArg, i))); // # nocov
+    }
+    ngrp = length(startsArg);
+    starts = INTEGER(startsArg);
+    if (length(oArg)) {
+      o = INTEGER(oArg);
+    } else { // already grouped
+      int *io = (int *)R_alloc(n, sizeof(*io));
+      for (int r=0; r<n; ++r) io[r] = r+1;
+      o = io;
+    }
+  }
   SEXP target;
 
   SEXP ans = PROTECT(allocVector(VECSXP, nlhs + (nval * ncols)));
@@ -16,11 +163,18 @@ SEXP fcast(SEXP lhs, SEXP val, SEXP nrowArg, SEXP ncolArg, SEXP idxArg, SEXP fil
   }
   // get val cols
   bool some_fill = LOGICAL(some_fillArg)[0];
+  int nth = getDTthreads(n, true), nthfill = getDTthreads((int64_t)nrows*ncols, true);
   for (int i=0; i<nval; ++i) {
     const SEXP thiscol = VECTOR_ELT(val, i);
     SEXP thisfill = fill;
-    const SEXPTYPE thistype = TYPEOF(thiscol);
+    const int fun = agg ? funs[i] : -1;
+    const bool narm = agg && LOGICAL(narmArg)[i]==TRUE;
+    const SEXPTYPE thistype = agg ? castaggtype(fun, TYPEOF(thiscol)) : (SEXPTYPE)TYPEOF(thiscol);
+    const bool keepattr = !agg || fun==CAST_FIRST || fun==CAST_LAST;  // other aggregates are plain vectors
     int nprotect = 0;
+    // the aggregates other than first and last are not of the type of thiscol, so fill is coerced to an empty vector of their type
+    SEXP proto = thiscol;
+    if (!keepattr) { proto = PROTECT(allocVector(thistype, 0)); nprotect++; }
     if (some_fill) {
       if (isNull(fill)) {
         if (LOGICAL(is_agg)[0]) {
@@ -30,76 +184,128 @@ SEXP fcast(SEXP lhs, SEXP val, SEXP nrowArg, SEXP ncolArg, SEXP idxArg, SEXP fil
       }
       if (isVectorAtomic(thiscol)) { // defer error handling to below, but also skip on list
         // #5980: some callers used fill=list(...) and relied on R's coercion mechanics for lists, which are nontrivial, so just dispatch and double-coerce.
-        if (isNewList(thisfill)) { thisfill = PROTECT(coerceVector(thisfill, TYPEOF(thiscol))); nprotect++; }
-        thisfill = PROTECT(coerceAs(thisfill, thiscol, /*copyArg=*/ScalarLogical(false))); nprotect++;
+        if (isNewList(thisfill)) { thisfill = PROTECT(coerceVector(thisfill, thistype)); nprotect++; }
+        thisfill = PROTECT(coerceAs(thisfill, proto, /*copyArg=*/ScalarLogical(false))); nprotect++;
       }
     }
+    for (int j=0; j<ncols; ++j) {
+      SET_VECTOR_ELT(ans, nlhs+j+i*ncols, target=allocVector(thistype, nrows) );
+      if (keepattr) copyMostAttrib(thiscol, target);
+    }
+    // the cells left empty are filled in parallel over result columns, then the values are scattered in parallel over rows of val
+    // or aggregated in parallel over cells
+    #define FILL(CTYPE, RFUN) {                                                       \
+      CTYPE **td = (CTYPE **)R_alloc(ncols, sizeof(*td));                             \
+      for (int j=0; j<ncols; ++j) td[j] = RFUN(VECTOR_ELT(ans, nlhs+j+i*ncols));      \
+      if (some_fill) {                                                                \
+        const CTYPE fillv = RFUN(thisfill)[0];                                        \
+        _Pragma("omp parallel for num_threads(nthfill)")                              \
+        for (int j=0; j<ncols; ++j) {                                                 \
+          CTYPE *tdj = td[j];                                                         \
+          for (int k=0; k<nrows; ++k) tdj[k] = fillv;                                 \
+        }                                                                             \
+      }                                                                               \
+      if (!agg) {                                                                     \
+        const CTYPE *xd = (const CTYPE *)RFUN(thiscol);                               \
+        _Pragma("omp parallel for num_threads(nth)")                                  \
+        for (int r=0; r<n; ++r) td[colmap[r]-1][rowmap[r]-1] = xd[r];                 \
+      } else if (fun==CAST_FIRST || fun==CAST_LAST) {                                 \
+        const CTYPE *xd = (const CTYPE *)RFUN(thiscol);                               \
+        _Pragma("omp parallel for num_threads(nth)")                                  \
+        for (int g=0; g<ngrp; ++g) {                                                  \
+          const int from = starts[g]-1, to = g==ngrp-1 ? n : starts[g+1]-1;           \
+          const int r = o[fun==CAST_FIRST ? from : to-1]-1, c = o[from]-1;            \
+          td[colmap[c]-1][rowmap[c]-1] = xd[r];                                       \
+        }                                                                             \
+      } else AGG                                                                      \
+    }
+    bool overflow=false, noneleft=false;
     switch (thistype) {
     case INTSXP:
-    case LGLSXP: {
-      const int *ithiscol = INTEGER(thiscol);
-      const int *ithisfill = 0;
-      if (some_fill) ithisfill = INTEGER(thisfill);
-      for (int j=0; j<ncols; ++j) {
-        SET_VECTOR_ELT(ans, nlhs+j+i*ncols, target=allocVector(thistype, nrows) );
-        int *itarget = INTEGER(target);
-        copyMostAttrib(thiscol, target);
-        for (int k=0; k<nrows; ++k) {
-          int thisidx = idx[k*ncols + j];
-          itarget[k] = (thisidx == NA_INTEGER) ? ithisfill[0] : ithiscol[thisidx-1];
-        }
+    case LGLSXP:
+      #define AGG {                                                                                   \
+        const int *xd = (const int *)DATAPTR_RO(thiscol); /* integer or logical; not read by length */ \
+        _Pragma("omp parallel for num_threads(nth) reduction(||:overflow)")                           \
+        for (int g=0; g<ngrp; ++g) {                                                                  \
+          const int from = starts[g]-1, to = g==ngrp-1 ? n : starts[g+1]-1;                           \
+          const int c = o[from]-1;                                                                    \
+          td[colmap[c]-1][rowmap[c]-1] = castaggint(fun, xd, o, from, to, narm, &overflow);          \
+        }                                                                                             \
       }
-    } break;
-    case REALSXP: {
-      const double *dthiscol = REAL(thiscol);
-      const double *dthisfill = 0;
-      if (some_fill) dthisfill = REAL(thisfill);
-      for (int j=0; j<ncols; ++j) {
-        SET_VECTOR_ELT(ans, nlhs+j+i*ncols, target=allocVector(thistype, nrows) );
-        double *dtarget = REAL(target);
-        copyMostAttrib(thiscol, target);
-        for (int k=0; k<nrows; ++k) {
-          int thisidx = idx[k*ncols + j];
-          dtarget[k] = (thisidx == NA_INTEGER) ? dthisfill[0] : dthiscol[thisidx-1];
+      FILL(int, INTEGER)
+      #undef AGG
+      break;
+    case REALSXP:
+      #define AGG {                                                                                   \
+        if (TYPEOF(thiscol)==REALSXP) {                                                               \
+          const double *xd = REAL(thiscol);                                                           \
+          _Pragma("omp parallel for num_threads(nth) reduction(||:noneleft)")                         \
+          for (int g=0; g<ngrp; ++g) {                                                                \
+            const int from = starts[g]-1, to = g==ngrp-1 ? n : starts[g+1]-1;                         \
+            const int c = o[from]-1;                                                                  \
+            td[colmap[c]-1][rowmap[c]-1] = castaggdouble(fun, xd, o, from, to, narm, &noneleft);     \
+          }                                                                                           \
+        } else { /* mean of integer or logical */                                                     \
+          const int *xd = (const int *)DATAPTR_RO(thiscol);                                           \
+          _Pragma("omp parallel for num_threads(nth)")                                                \
+          for (int g=0; g<ngrp; ++g) {                                                                \
+            const int from = starts[g]-1, to = g==ngrp-1 ? n : starts[g+1]-1;                         \
+            const int c = o[from]-1;                                                                  \
+            td[colmap[c]-1][rowmap[c]-1] = castaggmeanint(xd, o, from, to, narm);                    \
+          }                                                                                           \
+        }                                                                                             \
+      }
+      FILL(double, REAL)
+      #undef AGG
+      break;
+    case CPLXSXP:
+      #define AGG internal_error(__func__, "fun '%s' of complex", castfunnames[fun]); // # nocov
+      FILL(Rcomplex, COMPLEX)
+      #undef AGG
+      break;
+    case STRSXP: {
+      const SEXP *xd = STRING_PTR_RO(thiscol);
+      if (some_fill) {
+        const SEXP fillv = STRING_ELT(thisfill, 0);
+        for (int j=0; j<ncols; ++j) {
+          target = VECTOR_ELT(ans, nlhs+j+i*ncols);
+          for (int k=0; k<nrows; ++k) SET_STRING_ELT(target, k, fillv);
         }
       }
-    } break;
-    case CPLXSXP: {
-      const Rcomplex *zthiscol = COMPLEX(thiscol);
-      const Rcomplex *zthisfill = 0;
-      if (some_fill) zthisfill = COMPLEX(thisfill);
-      for (int j=0; j<ncols; ++j) {
-        SET_VECTOR_ELT(ans, nlhs+j+i*ncols, target=allocVector(thistype, nrows) );
-        Rcomplex *ztarget = COMPLEX(target);
-        copyMostAttrib(thiscol, target);
-        for (int k=0; k<nrows; ++k) {
-          int thisidx = idx[k*ncols + j];
-          ztarget[k] = (thisidx == NA_INTEGER) ? zthisfill[0] : zthiscol[thisidx-1];
+      if (!agg) {
+        for (int r=0; r<n; ++r) SET_STRING_ELT(VECTOR_ELT(ans, nlhs+colmap[r]-1+i*ncols), rowmap[r]-1, xd[r]);
+      } else {
+        for (int g=0; g<ngrp; ++g) {
+          const int from = starts[g]-1, to = g==ngrp-1 ? n : starts[g+1]-1;
+          const int r = o[fun==CAST_FIRST ? from : to-1]-1, c = o[from]-1;
+          SET_STRING_ELT(VECTOR_ELT(ans, nlhs+colmap[c]-1+i*ncols), rowmap[c]-1, xd[r]);
         }
       }
     } break;
-    case STRSXP:
-      for (int j=0; j<ncols; ++j) {
-        SET_VECTOR_ELT(ans, nlhs+j+i*ncols, target=allocVector(thistype, nrows) );
-        copyMostAttrib(thiscol, target);
-        for (int k=0; k<nrows; ++k) {
-          int thisidx = idx[k*ncols + j];
-          SET_STRING_ELT(target, k, (thisidx == NA_INTEGER) ? STRING_ELT(thisfill, 0) : STRING_ELT(thiscol, thisidx-1));
+    case VECSXP: {
+      const SEXP *xd = SEXPPTR_RO(thiscol);
+      if (some_fill) {
+        const SEXP fillv = VECTOR_ELT(thisfill, 0);
+        for (int j=0; j<ncols; ++j) {
+          target = VECTOR_ELT(ans, nlhs+j+i*ncols);
+          for (int k=0; k<nrows; ++k) SET_VECTOR_ELT(target, k, fillv);
         }
       }
-      break;
-    case VECSXP:
-      for (int j=0; j<ncols; ++j) {
-        SET_VECTOR_ELT(ans, nlhs+j+i*ncols, target=allocVector(thistype, nrows) );
-        copyMostAttrib(thiscol, target);
-        for (int k=0; k<nrows; ++k) {
-          int thisidx = idx[k*ncols + j];
-          SET_VECTOR_ELT(target, k, (thisidx == NA_INTEGER) ? VECTOR_ELT(thisfill, 0) : VECTOR_ELT(thiscol, thisidx-1));
+      if (!agg) {
+        for (int r=0; r<n; ++r) SET_VECTOR_ELT(VECTOR_ELT(ans, nlhs+colmap[r]-1+i*ncols), rowmap[r]-1, xd[r]);
+      } else {
+        for (int g=0; g<ngrp; ++g) {
+          const int from = starts[g]-1, to = g==ngrp-1 ? n : starts[g+1]-1;
+          const int r = o[fun==CAST_FIRST ? from : to-1]-1, c = o[from]-1;
+          SET_VECTOR_ELT(VECTOR_ELT(ans, nlhs+colmap[c]-1+i*ncols), rowmap[c]-1, xd[r]);
         }
       }
-      break;
+    } break;
     default: error(_("Unsupported column type in fcast val: '%s'"), type2char(thistype)); // #nocov
     }
+    #undef FILL
+    if (overflow) warning(_("integer overflow - use sum(as.numeric(.))"));
+    if (noneleft) warning(_("no non-missing arguments to %s; returning %s"), castfunnames[fun], fun==CAST_MIN ? "Inf" : "-Inf");
     UNPROTECT(nprotect);
   }
   UNPROTECT(1);
@@ -0,0 +1,189 @@
+#include "data.table.h"
+
+/* cumulative (expanding window) sum, prod, max, min and mean, optionally within groups
+ * fcumsum(x)[i] is frollsum(x, seq_along(x), adaptive=TRUE)[i], in each group on its own when by is given
+ *   without na.rm NA takes precedence over NaN, with na.rm both are skipped
+ * the (group-sorted) sequence of observations is cut into one chunk per thread and scanned as a segmented scan
+ *   1) each chunk aggregates its observations after its last group start, in parallel
+ *   2) the carry into each chunk is the aggregate of the previous chunk, combined with the carry into the previous
+ *      chunk when it has no group start, sequentially over chunks
+ *   3) each chunk scans again starting from its carry, resetting at every group start, in parallel
+ * so every observation is read twice at most, whatever the number and sizes of groups
+ */
+
+typedef struct {
+  long double v; // sum, product, max or min so far
+  int64_t n;     // number of non-NA observations so far, for mean
+  bool na, nan;  // NA or NaN seen so far, only when !narm
+} cum_t;
+
+static inline cum_t cuminit(rollfun_t rfun) {
+  return (cum_t) { .v = rfun==PROD ? 1.0 : rfun==MAX ? R_NegInf : rfun==MIN ? R_PosInf : 0.0, .n=0, .na=false, .nan=false };
+}
+
+static inline void cumadd(rollfun_t rfun, cum_t *s, double xi, bool narm) {
+  if (ISNAN(xi)) {
+    if (!narm) {
+      if (ISNA(xi)) s->na = true; else s->nan = true;
+    }
+    return;
+  }
+  switch (rfun) {
+  case PROD : s->v *= xi; break;
+  case MAX : if (xi > s->v) s->v = xi; break;
+  case MIN : if (xi < s->v) s->v = xi; break;
+  default : s->v += xi; // SUM and MEAN
+  }
+  s->n++;
+}
+
+// a followed by b
+static inline cum_t cumcombine(rollfun_t rfun, cum_t a, cum_t b) {
+  switch (rfun) {
+  case PROD : a.v *= b.v; break;
+  case MAX : if (b.v > a.v) a.v = b.v; break;
+  case MIN : if (b.v < a.v) a.v = b.v; break;
+  default : a.v += b.v;
+  }
+  a.n += b.n;
+  a.na |= b.na;
+  a.nan |= b.nan;
+  return a;
+}
+
+static inline double cumvalue(rollfun_t rfun, cum_t s) {
+  if (s.na)
+    return NA_REAL;
+  if (s.nan)
+    return R_NaN;
+  if (rfun==MEAN)
+    return s.n ? (double)(s.v/s.n) : R_NaN;
+  return (double)s.v;
+}
+
+// index of the first group start >= p in gs[0..ngrp), also used by nafill.c
+int firststart(const int *gs, int ngrp, int64_t p) {
+  int lo=0, hi=ngrp;
+  while (lo < hi) {
+    const int mid = lo + (hi-lo)/2;
+    if (gs[mid] < p) lo = mid+1; else hi = mid;
+  }
+  return lo;
+}
+
+/* x of length nx is scanned in the order o (1-based), or as it is when o is NULL; answer is written back in the
+ * original order. gs are 0-based positions in the scan order where groups start, or NULL for a single group
+ */
+void fcumfun(rollfun_t rfun, const double *x, uint64_t nx, ans_t *ans, const int *o, const int *gs, int ngrp, bool narm, bool verbose) {
+  double tic = 0;
+  if (verbose)
+    tic = omp_get_wtime();
+  int nc = nx ? getDTthreads(nx, true) : 1;
+  cum_t *tail = malloc(sizeof(*tail) * nc), *carry = malloc(sizeof(*carry) * nc);
+  bool *hasstart = malloc(sizeof(*hasstart) * nc);
+  if (!tail || !carry || !hasstart) { // # nocov start
+    free(tail); free(carry); free(hasstart);
+    ansSetMsg(ans, 3, "%s: Unable to allocate memory for chunks", __func__); // raise error
+    return;
+  } // # nocov end
+  if (verbose)
+    snprintf(end(ans->message[0]), 500, _("%s: scanning %"PRIu64" observations in %d group(s), in %d chunk(s)\n"), __func__, nx, gs ? ngrp : 1, nc);
+  const cum_t init = cuminit(rfun);
+  if (nc > 1) {
+    #pragma omp parallel for num_threads(nc)
+    for (int c=0; c<nc; c++) {
+      const int64_t from = nx*c/nc, to = nx*(c+1)/nc;
+      int64_t p = from;
+      hasstart[c] = from==0;
+      if (gs) {
+        const int g = firststart(gs, ngrp, to) - 1; // last group start before to
+        if (g >= 0 && gs[g] >= from) {
+          p = gs[g];
+          hasstart[c] = true;
+        }
+      }
+      cum_t s = init;
+      for (; p<to; p++)
+        cumadd(rfun, &s, x[o ? o[p]-1 : p], narm);
+      tail[c] = s;
+    }
+  }
+  carry[0] = init;
+  for (int c=1; c<nc; c++)
+    carry[c] = hasstart[c-1] ? tail[c-1] : cumcombine(rfun, carry[c-1], tail[c-1]);
+  double *restrict ansv = ans->dbl_v;
+  #pragma omp parallel for num_threads(nc)
+  for (int c=0; c<nc; c++) {
+    const int64_t from = nx*c/nc, to = nx*(c+1)/nc;
+    int g = gs ? firststart(gs, ngrp, from) : 0;
+    cum_t s = carry[c];
+    for (int64_t p=from; p<to; p++) {
+      if (gs && g<ngrp && gs[g]==p) {
+        s = init;
+        g++;
+      }
+      const int64_t i = o ? o[p]-1 : p;
+      cumadd(rfun, &s, x[i], narm);
+      ansv[i] = cumvalue(rfun, s);
+    }
+  }
+  free(tail); free(carry); free(hasstart);
+  if (verbose)
+    snprintf(end(ans->message[0]), 500, _("%s: took %.3fs\n"), __func__, omp_get_wtime()-tic);
+}
+
+// o is the order of groups from forderv, integer() when already grouped, or NULL; starts are 1-based starts of groups in o, or NULL
+SEXP fcumR(SEXP fun, SEXP xobj, SEXP narm, SEXP o, SEXP starts) {
+  int protecti = 0;
+  const bool verbose = GetVerbose();
+  if (!xlength(xobj))
+    return(xobj);                                                // empty input: NULL, list()
+  rollfun_t rfun = SUM;
+  if (!strcmp(CHAR(STRING_ELT(fun, 0)), "sum")) {
+    rfun = SUM;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "prod")) {
+    rfun = PROD;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "max")) {
+    rfun = MAX;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "min")) {
+    rfun = MIN;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "mean")) {
+    rfun = MEAN;
+  } else {
+    internal_error(__func__, "invalid %s argument in %s function should have been caught earlier", "fun", "cumulative"); // # nocov
+  }
+  if (!IS_TRUE_OR_FALSE(narm))
+    error(_("%s must be TRUE or FALSE"), "na.rm");
+  const bool bnarm = LOGICAL(narm)[0];
+
+  SEXP x = PROTECT(coerceX(xobj, /*intok=*/false)); protecti++;
+  R_len_t nx = length(x);
+  const int *io = NULL, *gs = NULL;
+  int ngrp = 0;
+  if (!isNull(o) && length(o))
+    io = INTEGER_RO(o);
+  if (!isNull(starts)) {
+    ngrp = length(starts);
+    const int *is = INTEGER_RO(starts);
+    int *igs = (int *)R_alloc(ngrp, sizeof(*igs));
+    for (int g=0; g<ngrp; g++) igs[g] = is[g]-1;
+    gs = igs;
+  }
+  SEXP ans = PROTECT(allocVector(VECSXP, nx)); protecti++;
+  ans_t *dans = (ans_t *)R_alloc(nx, sizeof(*dans));
+  for (R_len_t i=0; i<nx; i++) {
+    SEXP xi = VECTOR_ELT(x, i);
+    if (io && xlength(xi)!=length(o))
+      internal_error(__func__, "length of order %d does not match length of column %d, %"PRId64, length(o), i+1, (int64_t)xlength(xi)); // # nocov
+    SEXP ansi = allocVector(REALSXP, xlength(xi));
+    SET_VECTOR_ELT(ans, i, ansi);
+    dans[i] = ((ans_t) { .dbl_v=REAL(ansi), .status=0, .message={"\0","\0","\0","\0"} });
+  }
+  for (R_len_t i=0; i<nx; i++) {
+    SEXP xi = VECTOR_ELT(x, i);
+    fcumfun(rfun, REAL_RO(xi), xlength(xi), &dans[i], io, gs, ngrp, bnarm, verbose);
+  }
+  ansGetMsgs(dans, nx, verbose, __func__);
+  UNPROTECT(protecti);
+  return isVectorAtomic(xobj) && length(ans) == 1 ? VECTOR_ELT(ans, 0) : ans;
+}
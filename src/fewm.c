@@ -0,0 +1,253 @@
+#include "data.table.h"
+
+/* exponentially weighted moving average and variance, optionally within groups
+ * observation i of n so far has weight c_i*(1-alpha)^(n-1-i), where c_i is 1 when adjust, otherwise alpha but 1 for the first
+ *   observation, so !adjust is the recursion y_0=x_0, y_i=(1-alpha)*y_{i-1}+alpha*x_i
+ * without na.rm NA takes precedence over NaN and sticks, with na.rm missing values are skipped as if they were not in x
+ * infinite observations are not weighted into the state but flagged, they stick as well unless alpha is 1
+ * the state is the sum of weights, weighted mean and weighted sum of squared deviations (West's update), so a state decays by
+ *   multiplying its weights, and two states combine like Chan's parallel variance
+ * the (group-sorted) sequence of observations is cut into one chunk per thread and scanned like fcumfun in fcum.c
+ *   1) each chunk aggregates its observations after its last group start, in parallel
+ *   2) the carry into each chunk is the aggregate of the previous chunk, combined with the carry into the previous
+ *      chunk when it has no group start, sequentially over chunks
+ *   3) each chunk scans again starting from its carry, resetting at every group start, in parallel
+ */
+
+typedef struct {
+  double w, w2;  // sum of weights and of squared weights
+  double m, m2;  // weighted mean and weighted sum of squared deviations from it
+  double xf;     // first observation, its weight is corrected when it turns out to be first of its group
+  int64_t n;     // number of observations, earlier observations decay once for each of them
+  bool fresh;    // state starts at a group start
+  bool na, nan;  // NA or NaN seen so far, only when !narm
+  bool pinf, ninf; // Inf or -Inf seen so far
+} ewm_t;
+
+static inline ewm_t ewminit(bool fresh) {
+  return (ewm_t) { .w=0.0, .w2=0.0, .m=0.0, .m2=0.0, .xf=0.0, .n=0, .fresh=fresh, .na=false, .nan=false, .pinf=false, .ninf=false };
+}
+
+// add observation xi of weight c to s, without decaying s
+static inline void ewmpoint(ewm_t *s, double xi, double c) {
+  s->w += c;
+  const double delta = xi - s->m;
+  s->m += delta * c / s->w;
+  s->m2 += c * delta * (xi - s->m);
+}
+
+// hasnf false skips testing for non-finite values, they then turn the answer into NaN which is checked by the caller
+static inline void ewmadd(ewm_t *s, double xi, double d, double alpha, bool adjust, bool narm, bool hasnf) {
+  if (hasnf && ISNAN(xi)) {
+    if (!narm) {
+      if (ISNA(xi)) s->na = true; else s->nan = true;
+    }
+    return;
+  }
+  const double c = adjust || (s->n==0 && s->fresh) ? 1.0 : alpha;
+  if (s->n==0)
+    s->xf = xi;
+  s->w *= d; s->w2 *= d*d; s->m2 *= d;
+  if (d == 0.0) // alpha 1 forgets all earlier observations
+    s->pinf = s->ninf = false;
+  if (hasnf && !R_FINITE(xi)) {
+    if (xi > 0) s->pinf = true; else s->ninf = true;
+  } else {
+    s->w2 += c*c;
+    ewmpoint(s, xi, c);
+  }
+  s->n++;
+}
+
+// a followed by b, b has no group start, a starts at a group start or follows one
+static inline ewm_t ewmcombine(ewm_t a, ewm_t b, double d, double alpha, bool adjust) {
+  if (!adjust && a.n==0 && b.n>0 && R_FINITE(b.xf)) { // first observation of b is the first of its group, weighted by 1 rather than alpha
+    const double df = pow(d, (double)(b.n-1));
+    b.w2 += df*df*(1.0-alpha*alpha);
+    ewmpoint(&b, b.xf, (1.0-alpha)*df);
+  }
+  const double D = pow(d, (double)b.n);
+  a.w *= D; a.w2 *= D*D; a.m2 *= D;
+  if (d == 0.0 && b.n > 0)
+    a.pinf = a.ninf = false;
+  const double w = a.w + b.w;
+  if (w > 0) {
+    const double delta = b.m - a.m;
+    a.m += delta * b.w / w;
+    a.m2 += b.m2 + delta * delta * a.w * b.w / w;
+  }
+  a.w = w;
+  a.w2 += b.w2;
+  if (a.n==0)
+    a.xf = b.xf;
+  a.n += b.n;
+  a.na |= b.na;
+  a.nan |= b.nan;
+  a.pinf |= b.pinf;
+  a.ninf |= b.ninf;
+  return a;
+}
+
+static inline double ewmvalue(rollfun_t rfun, ewm_t s, bool bias) {
+  if (s.na)
+    return NA_REAL;
+  if (s.nan)
+    return R_NaN;
+  if (s.pinf || s.ninf)
+    return rfun==EWMA && !(s.pinf && s.ninf) ? (s.pinf ? R_PosInf : R_NegInf) : R_NaN;
+  if (rfun==EWMA)
+    return s.n ? s.m : R_NaN;
+  const double m2 = s.m2 < 0 ? 0.0 : s.m2; // round off, NaN of unchecked NA passes
+  if (bias)
+    return s.n ? m2 / s.w : NA_REAL;
+  const double den = s.w*s.w - s.w2;
+  return s.n > 1 && den > 0 ? m2 * s.w / den : NA_REAL; // var(scalar) is NA
+}
+
+/* x of length nx is scanned in the order o (1-based), or as it is when o is NULL; answer is written back in the
+ * original order. gs are 0-based positions in the scan order where groups start, or NULL for a single group
+ * nc is number of chunks, each scanned by its own thread
+ */
+void fewmfun(rollfun_t rfun, const double *x, uint64_t nx, ans_t *ans, double alpha, bool adjust, bool bias, const int *o, const int *gs, int ngrp, bool narm, int hasnf, int nc, bool verbose) {
+  double tic = 0;
+  if (verbose)
+    tic = omp_get_wtime();
+  ewm_t *tail = malloc(sizeof(*tail) * nc), *carry = malloc(sizeof(*carry) * nc);
+  bool *hasstart = malloc(sizeof(*hasstart) * nc), *nf = malloc(sizeof(*nf) * nc);
+  if (!tail || !carry || !hasstart || !nf) { // # nocov start
+    free(tail); free(carry); free(hasstart); free(nf);
+    ansSetMsg(ans, 3, "%s: Unable to allocate memory for chunks", __func__); // raise error
+    return;
+  } // # nocov end
+  if (verbose)
+    snprintf(end(ans->message[0]), 500, _("%s: scanning %"PRIu64" observations in %d group(s), in %d chunk(s), alpha %g, hasnf %d, narm %d\n"), __func__, nx, gs ? ngrp : 1, nc, alpha, hasnf, (int)narm);
+  const double d = 1.0 - alpha;
+  double *restrict ansv = ans->dbl_v;
+  bool care = hasnf != -1;
+  for (int run=0; run<2; run++) { // second run only when has.nf=FALSE turned out to be wrong
+    if (nc > 1) {
+      #pragma omp parallel for num_threads(nc)
+      for (int c=0; c<nc; c++) {
+        const int64_t from = nx*c/nc, to = nx*(c+1)/nc;
+        int64_t p = from;
+        hasstart[c] = from==0;
+        if (gs) {
+          const int g = firststart(gs, ngrp, to) - 1; // last group start before to
+          if (g >= 0 && gs[g] >= from) {
+            p = gs[g];
+            hasstart[c] = true;
+          }
+        }
+        ewm_t s = ewminit(hasstart[c]);
+        for (; p<to; p++)
+          ewmadd(&s, x[o ? o[p]-1 : p], d, alpha, adjust, narm, care);
+        tail[c] = s;
+      }
+    }
+    carry[0] = ewminit(true);
+    for (int c=1; c<nc; c++)
+      carry[c] = hasstart[c-1] ? tail[c-1] : ewmcombine(carry[c-1], tail[c-1], d, alpha, adjust);
+    #pragma omp parallel for num_threads(nc)
+    for (int c=0; c<nc; c++) {
+      const int64_t from = nx*c/nc, to = nx*(c+1)/nc;
+      int g = gs ? firststart(gs, ngrp, from) : 0;
+      ewm_t s = carry[c];
+      bool cnf = false;
+      for (int64_t p=from; p<to; p++) {
+        if (gs && g<ngrp && gs[g]==p) {
+          s = ewminit(true);
+          g++;
+        }
+        const int64_t i = o ? o[p]-1 : p;
+        ewmadd(&s, x[i], d, alpha, adjust, narm, care);
+        ansv[i] = ewmvalue(rfun, s, bias);
+        cnf |= !R_FINITE(ansv[i]);
+      }
+      nf[c] = cnf;
+    }
+    if (care)
+      break;
+    bool anynf = false;
+    for (int c=0; c<nc; c++)
+      anynf |= nf[c];
+    if (!anynf)
+      break;
+    ansSetMsg(ans, 2, "%s: has.nf=FALSE used but non-finite values are present in input, use default has.nf=NA to avoid this warning", __func__);
+    if (verbose)
+      ansSetMsg(ans, 0, "%s: non-finite values are present in input, re-running with extra care for NFs\n", __func__);
+    care = true;
+  }
+  free(tail); free(carry); free(hasstart); free(nf);
+  if (verbose)
+    snprintf(end(ans->message[0]), 500, _("%s: took %.3fs\n"), __func__, omp_get_wtime()-tic);
+}
+
+// o is the order of groups from forderv, integer() when already grouped, or NULL; starts are 1-based starts of groups in o, or NULL
+SEXP fewmR(SEXP fun, SEXP xobj, SEXP alpha, SEXP adjust, SEXP bias, SEXP narm, SEXP hasnf, SEXP o, SEXP starts) {
+  int protecti = 0;
+  const bool verbose = GetVerbose();
+  if (!xlength(xobj))
+    return(xobj);                                                // empty input: NULL, list()
+  rollfun_t rfun = EWMA;
+  if (!strcmp(CHAR(STRING_ELT(fun, 0)), "mean")) {
+    rfun = EWMA;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "var")) {
+    rfun = EWMVAR;
+  } else {
+    internal_error(__func__, "invalid %s argument in %s function should have been caught earlier", "fun", "exponentially weighted"); // # nocov
+  }
+  if (!isReal(alpha) || length(alpha)!=1 || ISNAN(REAL(alpha)[0]) || REAL(alpha)[0]<=0 || REAL(alpha)[0]>1)
+    internal_error(__func__, "alpha must be a number in (0, 1] and should have been checked earlier"); // # nocov
+  const double dalpha = REAL(alpha)[0];
+  if (!IS_TRUE_OR_FALSE(adjust))
+    error(_("%s must be TRUE or FALSE"), "adjust");
+  const bool badjust = LOGICAL(adjust)[0];
+  if (!IS_TRUE_OR_FALSE(bias))
+    error(_("%s must be TRUE or FALSE"), "bias");
+  const bool bbias = LOGICAL(bias)[0];
+  if (!IS_TRUE_OR_FALSE(narm))
+    error(_("%s must be TRUE or FALSE"), "na.rm");
+  const bool bnarm = LOGICAL(narm)[0];
+  if (!isLogical(hasnf) || length(hasnf)!=1)
+    error(_("has.nf must be TRUE, FALSE or NA"));
+  if (LOGICAL(hasnf)[0]==FALSE && bnarm)
+    error(_("using has.nf FALSE and na.rm TRUE does not make sense, if you know there are non-finite values then use has.nf TRUE, otherwise leave it as default NA"));
+  const int ihasnf = LOGICAL(hasnf)[0]==NA_LOGICAL ? 0 : LOGICAL(hasnf)[0]==TRUE ? 1 : -1;
+
+  SEXP x = PROTECT(coerceX(xobj, /*intok=*/false)); protecti++;
+  R_len_t nx = length(x);
+  const int *io = NULL, *gs = NULL;
+  int ngrp = 0;
+  if (!isNull(o) && length(o))
+    io = INTEGER_RO(o);
+  if (!isNull(starts)) {
+    ngrp = length(starts);
+    const int *is = INTEGER_RO(starts);
+    int *igs = (int *)R_alloc(ngrp, sizeof(*igs));
+    for (int g=0; g<ngrp; g++) igs[g] = is[g]-1;
+    gs = igs;
+  }
+  SEXP ans = PROTECT(allocVector(VECSXP, nx)); protecti++;
+  ans_t *dans = (ans_t *)R_alloc(nx, sizeof(*dans));
+  const double **dx = (const double **)R_alloc(nx, sizeof(*dx));
+  uint64_t *inx = (uint64_t *)R_alloc(nx, sizeof(*inx));
+  for (R_len_t i=0; i<nx; i++) {
+    SEXP xi = VECTOR_ELT(x, i);
+    if (io && xlength(xi)!=length(o))
+      internal_error(__func__, "length of order %d does not match length of column %d, %"PRId64, length(o), i+1, (int64_t)xlength(xi)); // # nocov
+    SEXP ansi = allocVector(REALSXP, xlength(xi));
+    SET_VECTOR_ELT(ans, i, ansi);
+    dans[i] = ((ans_t) { .dbl_v=REAL(ansi), .status=0, .message={"\0","\0","\0","\0"} });
+    dx[i] = REAL_RO(xi);
+    inx[i] = xlength(xi);
+  }
+  // many columns are scanned in parallel, one thread each; otherwise each column is scanned in parallel over chunks of its rows
+  int nthcol = getDTthreads(nx, true);
+  #pragma omp parallel for if (nthcol>1) num_threads(nthcol)
+  for (R_len_t i=0; i<nx; i++) {
+    fewmfun(rfun, dx[i], inx[i], &dans[i], dalpha, badjust, bbias, io, gs, ngrp, bnarm, ihasnf, nthcol>1 ? 1 : getDTthreads(inx[i], true), verbose);
+  }
+  ansGetMsgs(dans, nx, verbose, __func__);
+  UNPROTECT(protecti);
+  return isVectorAtomic(xobj) && length(ans) == 1 ? VECTOR_ELT(ans, 0) : ans;
+}
@@ -281,12 +281,17 @@ SEXP checkVars(SEXP DT, SEXP id, SEXP measure, Rboolean verbose) {
   return(ans);
 }
 
+#define MELT_BLOCK 65536  // rows of an input column copied by one task; a multiple of 64 so tasks never share a word of the keep mask
+
 struct processData {
-  SEXP RCHK;           // a 2 item list holding vars (result of checkVars) and not_NA_indices. PROTECTed up in fmelt so that preprocess() doesn't need to PROTECT. To pass rchk, #2865
-  SEXP idcols;         // convenience pointers into RCHK[0][0], RCHK[0][1] and RCHK[1] respectively
+  SEXP RCHK;           // a 1 item list holding vars (result of checkVars). PROTECTed up in fmelt so that preprocess() doesn't need to PROTECT. To pass rchk, #2865
+  SEXP idcols;         // convenience pointers into RCHK[0][0] and RCHK[0][1] respectively
   SEXP variable_table; // NULL or data for variable column(s).
   SEXP valuecols;      // list with one element per output/value column, each element is an integer vector.
-  SEXP not_NA_indices;
+  uint64_t *keep;      // na.rm: bit mask of the rows to keep, nword words for each input column (element of valuecols).
+  int64_t *keepstart;  // na.rm: position in output of the first kept row of each block of each input column, totlen at the end.
+  size_t nword;        // na.rm: words of keep for each input column.
+  int nblock;          // number of blocks of MELT_BLOCK rows in an input column.
   int *isfactor;
   int *leach;          // length of each element of the valuecols(measure.vars) list.
   int *isidentical;    // are all inputs for this value column the same type?
@@ -359,9 +364,10 @@ static void preprocess(SEXP DT, SEXP id, SEXP measure, SEXP varnames, SEXP valna
       }
     }
   }
-  if (data->narm) {
-    SET_VECTOR_ELT(data->RCHK, 1, data->not_NA_indices = allocVector(VECSXP, data->lmax));
-  }
+  data->nblock = (int)(((int64_t)data->nrow + MELT_BLOCK - 1) / MELT_BLOCK);
+  data->keep = NULL;
+  data->keepstart = NULL;
+  data->nword = 0;
   // TDH 1 Oct 2020 variable table.
   data->variable_table = getAttrib(measure, sym_variable_table);
   if (isNull(data->variable_table)) {
@@ -459,6 +465,174 @@ SEXP input_col_or_NULL(SEXP DT, struct processData* data, SEXP thisvaluecols, in
   return R_NilValue;
 }
 
+// position in output of the first row from input column j, and the number of rows from it in output
+static inline int64_t outstart(const struct processData *data, int j) {
+  return data->narm ? data->keepstart[(int64_t)j*data->nblock] : (int64_t)j*data->nrow;
+}
+
+static inline int outlen(const struct processData *data, int j) {
+  return data->narm ? (int)(data->keepstart[(int64_t)(j+1)*data->nblock] - data->keepstart[(int64_t)j*data->nblock]) : data->nrow;
+}
+
+static inline bool iskept(const struct processData *data, int j, int row) {
+  return !data->narm || (data->keep[j*data->nword + row/64] >> (row%64) & 1);
+}
+
+// the rows [*from, *to) of output written by task t, which is block t%nblock of input column t/nblock
+static inline void taskrange(const struct processData *data, int64_t t, int64_t *from, int64_t *to) {
+  if (data->narm) {
+    *from = data->keepstart[t];
+    *to = data->keepstart[t+1];
+  } else {
+    const int j = t/data->nblock, b = t%data->nblock;
+    *from = (int64_t)j*data->nrow + (int64_t)b*MELT_BLOCK;
+    *to = (int64_t)j*data->nrow + (data->nrow - b*MELT_BLOCK > MELT_BLOCK ? (int64_t)(b+1)*MELT_BLOCK : data->nrow);
+  }
+}
+
+typedef struct {
+  SEXPTYPE type; // NILSXP when the input column is missing
+  bool int64;
+  const void *p;
+  SEXP x;
+} nacol_t;
+
+// as is.na() of a list element, like dt_na
+static bool listeltNA(SEXP x) {
+  if (length(x) != 1) return false;
+  switch (TYPEOF(x)) {
+  case LGLSXP : return LOGICAL(x)[0] == NA_LOGICAL;
+  case INTSXP : return INTEGER(x)[0] == NA_INTEGER;
+  case STRSXP : return STRING_ELT(x, 0) == NA_STRING;
+  case CPLXSXP : return ISNAN(COMPLEX(x)[0].r) || ISNAN(COMPLEX(x)[0].i);
+  case REALSXP : return INHERITS(x, char_integer64) ? ((const int64_t *)REAL(x))[0] == NA_INTEGER64 : ISNAN(REAL(x)[0]);
+  default : return false;
+  }
+}
+
+static inline bool isNAat(const nacol_t *c, int row) {
+  switch (c->type) {
+  case LGLSXP :
+  case INTSXP : return ((const int *)c->p)[row] == NA_INTEGER;
+  case REALSXP : return c->int64 ? ((const int64_t *)c->p)[row] == NA_INTEGER64 : ISNAN(((const double *)c->p)[row]);
+  case CPLXSXP : return ISNAN(((const Rcomplex *)c->p)[row].r) || ISNAN(((const Rcomplex *)c->p)[row].i);
+  case STRSXP : return ((const SEXP *)c->p)[row] == NA_STRING;
+  case VECSXP : return listeltNA(VECTOR_ELT(c->x, row));
+  default : return false; // no such thing as a raw NA
+  }
+}
+
+/* na.rm=TRUE: a row of input column j is kept when none of the value columns is NA in that row, and none is kept
+ * when one of them is missing (NA in measure.vars). Kept rows are marked in a bit mask and counted by blocks in parallel,
+ * then the running total of the counts gives where each block goes in output, so the value, variable and id columns
+ * can all be filled in parallel by block, without collecting the indices of kept rows.
+ */
+static void countkept(SEXP DT, struct processData *data, Rboolean verbose) {
+  double tic = verbose ? omp_get_wtime() : 0;
+  const int lmax=data->lmax, lvalues=data->lvalues, nrow=data->nrow, nblock=data->nblock;
+  const int64_t ntask = (int64_t)lmax*nblock;
+  data->nword = ((size_t)nrow + 63) / 64;
+  data->keep = (uint64_t *)R_alloc((size_t)lmax*data->nword, sizeof(*data->keep));
+  data->keepstart = (int64_t *)R_alloc(ntask+1, sizeof(*data->keepstart));
+  nacol_t *cols = (nacol_t *)R_alloc((size_t)lmax*lvalues, sizeof(*cols));
+  bool anylist = false;
+  for (int j=0; j<lmax; ++j) {
+    for (int i=0; i<lvalues; ++i) {
+      SEXP thiscol = input_col_or_NULL(DT, data, VECTOR_ELT(data->valuecols, i), i, j);
+      nacol_t *c = cols + (size_t)j*lvalues + i;
+      *c = (nacol_t){ .type=TYPEOF(thiscol), .int64=INHERITS(thiscol, char_integer64), .p=NULL, .x=thiscol };
+      switch (c->type) {
+      case NILSXP : case VECSXP : case RAWSXP : break;
+      case STRSXP : c->p = STRING_PTR_RO(thiscol); break;
+      default : c->p = DATAPTR_RO(thiscol);
+      }
+      if (c->type == VECSXP) anylist = true;
+    }
+  }
+  // VECTOR_ELT may allocate for an ALTREP list, so list columns are checked on one thread
+  int nth = anylist ? 1 : getDTthreads(ntask, true);
+  #pragma omp parallel for schedule(dynamic) num_threads(nth)
+  for (int64_t t=0; t<ntask; ++t) {
+    const int j = t/nblock, b = t%nblock;
+    const int from = b*MELT_BLOCK, to = nrow-from > MELT_BLOCK ? from+MELT_BLOCK : nrow;
+    const nacol_t *c = cols + (size_t)j*lvalues;
+    uint64_t *mask = data->keep + j*data->nword;
+    memset(mask + from/64, 0, ((to-from+63)/64)*sizeof(*mask));
+    bool missing = false;
+    for (int i=0; i<lvalues; ++i) missing |= c[i].type == NILSXP;
+    int64_t n = 0;
+    for (int row=from; row<to && !missing; ++row) {
+      bool na = false;
+      for (int i=0; i<lvalues && !na; ++i) na = isNAat(c+i, row);
+      if (!na) {
+        mask[row/64] |= (uint64_t)1 << (row%64);
+        n++;
+      }
+    }
+    data->keepstart[t+1] = n;
+  }
+  data->keepstart[0] = 0;
+  for (int64_t t=0; t<ntask; ++t) data->keepstart[t+1] += data->keepstart[t];
+  if (data->keepstart[ntask] > INT_MAX)
+    error(_("Molten data would have %"PRId64" rows which is more than the limit of %d."), data->keepstart[ntask], INT_MAX); // # nocov
+  data->totlen = (int)data->keepstart[ntask];
+  if (verbose)
+    Rprintf(_("na.rm=TRUE kept %d of %"PRId64" rows, checking %"PRId64" block(s) of rows using %d thread(s) took %.3fs\n"), data->totlen, (int64_t)lmax*nrow, ntask, nth, omp_get_wtime()-tic);
+}
+
+/* copies input columns src[j] (NULL when missing) with elements of size bytes into target, the kept rows only when na.rm,
+ * in parallel over the blocks of all input columns. Not for character and list since SET_STRING_ELT and SET_VECTOR_ELT
+ * are not thread safe
+ */
+static void meltcopy(void *target, const void **src, size_t size, const struct processData *data) {
+  const int nrow=data->nrow, nblock=data->nblock;
+  const int64_t ntask = (int64_t)data->lmax*nblock;
+  #pragma omp parallel for schedule(dynamic) num_threads(getDTthreads(ntask, false))
+  for (int64_t t=0; t<ntask; ++t) {
+    const int j = t/nblock, b = t%nblock;
+    if (!src[j]) continue;
+    const int from = b*MELT_BLOCK, to = nrow-from > MELT_BLOCK ? from+MELT_BLOCK : nrow;
+    if (!data->narm) {
+      memcpy((char *)target + ((int64_t)j*nrow+from)*size, (const char *)src[j] + (size_t)from*size, (size_t)(to-from)*size);
+      continue;
+    }
+    const uint64_t *mask = data->keep + j*data->nword;
+    int64_t pos = data->keepstart[t];
+    switch (size) {
+    case 4 : {
+      int *d = (int *)target;
+      const int *s = (const int *)src[j];
+      for (int row=from; row<to; ++row) if (mask[row/64] >> (row%64) & 1) d[pos++] = s[row];
+    } break;
+    case 8 : {
+      int64_t *d = (int64_t *)target;
+      const int64_t *s = (const int64_t *)src[j];
+      for (int row=from; row<to; ++row) if (mask[row/64] >> (row%64) & 1) d[pos++] = s[row];
+    } break;
+    default :
+      for (int row=from; row<to; ++row) if (mask[row/64] >> (row%64) & 1) memcpy((char *)target + (pos++)*size, (const char *)src[j] + (size_t)row*size, size);
+    }
+  }
+}
+
+// fills the rows of target from input column j with val[j], in parallel; size is 4 or 8 bytes
+static void meltfill(void *target, const void *val, size_t size, const struct processData *data) {
+  const int64_t ntask = (int64_t)data->lmax*data->nblock;
+  #pragma omp parallel for schedule(dynamic) num_threads(getDTthreads(ntask, false))
+  for (int64_t t=0; t<ntask; ++t) {
+    const int j = t/data->nblock;
+    int64_t from, to;
+    taskrange(data, t, &from, &to);
+    if (size == 4) {
+      const int v = ((const int *)val)[j];
+      for (int64_t k=from; k<to; ++k) ((int *)target)[k] = v;
+    } else {
+      const int64_t v = ((const int64_t *)val)[j];
+      for (int64_t k=from; k<to; ++k) ((int64_t *)target)[k] = v;
+    }
+  }
+}
+
 SEXP getvaluecols(SEXP DT, SEXP dtnames, Rboolean valfactor, Rboolean verbose, struct processData *data) {
   for (int i=0; i<data->lvalues; ++i) {
     SEXP thisvaluecols = VECTOR_ELT(data->valuecols, i);
@@ -466,126 +640,79 @@ SEXP getvaluecols(SEXP DT, SEXP dtnames, Rboolean valfactor, Rboolean verbose, s
       warning(_("'measure.vars' [%s] are not all of the same type. By order of hierarchy, the molten data value column will be of type '%s'. All measure variables not of type '%s' will be coerced too. Check DETAILS in ?melt.data.table for more on coercion.\n"), concat(dtnames, thisvaluecols), type2char(data->maxtype[i]), type2char(data->maxtype[i]));
   }
   if (data->narm) {
-    SEXP seqcols = PROTECT(seq_int(data->lvalues, 1));
-    for (int i=0; i<data->lmax; ++i) {//element in measure vector.
-      SEXP valuecols_data = PROTECT(allocVector(VECSXP, data->lvalues));
-      int N_missing_columns = 0;
-      for (int j=0; j<data->lvalues; ++j) {//which measure vector/output col.
-        SEXP thisvaluecols = VECTOR_ELT(data->valuecols, j);
-        SEXP vec_or_NULL = input_col_or_NULL(DT, data, thisvaluecols, j, i);
-        if (vec_or_NULL == R_NilValue) {
-          N_missing_columns++;
-        }
-        SET_VECTOR_ELT(valuecols_data, j, vec_or_NULL);
-      }
-      if (N_missing_columns==0) {
-        SEXP any_missing = PROTECT(dt_na(valuecols_data, seqcols));
-        SEXP missing_indices;
-        SET_VECTOR_ELT(data->not_NA_indices, i, missing_indices=which(any_missing, FALSE));
-        data->totlen += length(missing_indices);
-        UNPROTECT(1); // any_missing
-      } else {
-        SET_VECTOR_ELT(data->not_NA_indices, i, allocVector(INTSXP, 0));
-      }
-      UNPROTECT(1); // valuecols_data
-    }
-    UNPROTECT(1);  // seqcols
+    countkept(DT, data, verbose);
   } else {
     data->totlen = data->nrow * data->lmax;
   }
   SEXP flevels = PROTECT(allocVector(VECSXP, data->lmax));
   Rboolean *isordered = (Rboolean *)R_alloc(data->lmax, sizeof(*isordered));
   SEXP ansvals = PROTECT(allocVector(VECSXP, data->lvalues));
+  SEXP srccols = PROTECT(allocVector(VECSXP, data->lmax)); // input columns, coerced to the type of target, until they are copied
+  const void **src = (const void **)R_alloc(data->lmax, sizeof(*src));
   for (int i=0; i<data->lvalues; ++i) {//for each output/value column.
     bool thisvalfactor = (data->maxtype[i] == VECSXP) ? false : valfactor;
     SEXP target = PROTECT(allocVector(data->maxtype[i], data->totlen)); // to keep rchk happy
     SET_VECTOR_ELT(ansvals, i, target);
     UNPROTECT(1);  // still protected by virtue of being member of protected ansval.
     SEXP thisvaluecols = VECTOR_ELT(data->valuecols, i); // integer vector of column ids.
-    int counter = 0;
     bool copyattr = false;
     for (int j=0; j<data->lmax; ++j) {// for each input column.
       int thisprotecti = 0;
+      src[j] = NULL;
       SEXP thiscol = input_col_or_NULL(DT, data, thisvaluecols, i, j);
       if (thiscol == R_NilValue) {
         if (!data->narm) {
-          writeNA(target, j*data->nrow, data->nrow, true);  // listNA=true #5053 
-        }
-      }else{
-        if (!copyattr && data->isidentical[i] && !data->isfactor[i]) {
-          copyMostAttrib(thiscol, target);
-          copyattr = true;
+          writeNA(target, j*data->nrow, data->nrow, true);  // listNA=true #5053
         }
-        if (TYPEOF(thiscol) != TYPEOF(target) && (data->maxtype[i] == VECSXP || !isFactor(thiscol))) {
-          thiscol = PROTECT(coerceVector(thiscol, TYPEOF(target)));  thisprotecti++;
-        }
-        const int *ithisidx = NULL;
-        int thislen = 0;
-        if (data->narm) {
-          SEXP thisidx = VECTOR_ELT(data->not_NA_indices, j);
-          ithisidx = INTEGER(thisidx);
-          thislen = length(thisidx);
-        }
-        size_t size = RTYPE_SIZEOF(thiscol);
-        switch (TYPEOF(target)) {
-        case VECSXP :
-          if (data->narm) {
-            for (int k=0; k<thislen; ++k)
-              SET_VECTOR_ELT(target, counter + k, VECTOR_ELT(thiscol, ithisidx[k]-1));
-          } else {
-            for (int k=0; k<data->nrow; ++k) SET_VECTOR_ELT(target, j*data->nrow + k, VECTOR_ELT(thiscol, k));
-          }
-          break;
-        case STRSXP :
-          if (data->isfactor[i]) {
-            if (isFactor(thiscol)) {
-              SET_VECTOR_ELT(flevels, j, getAttrib(thiscol, R_LevelsSymbol));
-              thiscol = PROTECT(asCharacterFactor(thiscol));  thisprotecti++;
-              isordered[j] = isOrdered(thiscol);
-            } else SET_VECTOR_ELT(flevels, j, thiscol);
-          }
-          if (data->narm) {
-            for (int k=0; k<thislen; ++k)
-              SET_STRING_ELT(target, counter + k, STRING_ELT(thiscol, ithisidx[k]-1));
-          } else {
-            for (int k=0; k<data->nrow; ++k) SET_STRING_ELT(target, j*data->nrow + k, STRING_ELT(thiscol, k));
-          }
-          break;
-          //TODO complex value type: case CPLXSXP: { } break;
-        case REALSXP : {
-          double *dtarget = REAL(target);
-          const double *dthiscol = REAL_RO(thiscol);
-          if (data->narm) {
-            for (int k=0; k<thislen; ++k)
-              dtarget[counter + k] = dthiscol[ithisidx[k]-1];
-          } else if (data->nrow) {
-            memcpy(dtarget + j*data->nrow, dthiscol, data->nrow*size);
-          }
-        }
-          break;
-        case INTSXP :
-        case LGLSXP : {
-          int *itarget = INTEGER(target);
-          const int *ithiscol = INTEGER_RO(thiscol);
-          if (data->narm) {
-            for (int k=0; k<thislen; ++k)
-              itarget[counter + k] = ithiscol[ithisidx[k]-1];
-          } else if (data->nrow) {
-            memcpy(itarget + j*data->nrow, ithiscol, data->nrow*size);
-          }
-        } break;
-        default :
-          error(_("Unknown column type '%s' for column '%s'."), type2char(TYPEOF(thiscol)), CHAR(STRING_ELT(dtnames, INTEGER(thisvaluecols)[i]-1)));
+        continue;
+      }
+      if (!copyattr && data->isidentical[i] && !data->isfactor[i]) {
+        copyMostAttrib(thiscol, target);
+        copyattr = true;
+      }
+      if (TYPEOF(thiscol) != TYPEOF(target) && (data->maxtype[i] == VECSXP || !isFactor(thiscol))) {
+        thiscol = PROTECT(coerceVector(thiscol, TYPEOF(target)));  thisprotecti++;
+      }
+      SET_VECTOR_ELT(srccols, j, thiscol);
+      int64_t pos = outstart(data, j);
+      switch (TYPEOF(target)) {
+      case VECSXP :
+        for (int k=0; k<data->nrow; ++k) if (iskept(data, j, k)) SET_VECTOR_ELT(target, pos++, VECTOR_ELT(thiscol, k));
+        break;
+      case STRSXP : {
+        if (data->isfactor[i]) {
+          if (isFactor(thiscol)) {
+            SET_VECTOR_ELT(flevels, j, getAttrib(thiscol, R_LevelsSymbol));
+            thiscol = PROTECT(asCharacterFactor(thiscol));  thisprotecti++;
+            isordered[j] = isOrdered(thiscol);
+          } else SET_VECTOR_ELT(flevels, j, thiscol);
         }
-        if (data->narm) counter += thislen;
+        const SEXP *s = STRING_PTR_RO(thiscol);
+        for (int k=0; k<data->nrow; ++k) if (iskept(data, j, k)) SET_STRING_ELT(target, pos++, s[k]);
+      } break;
+        //TODO complex value type: case CPLXSXP: { } break;
+      case REALSXP :
+      case INTSXP :
+      case LGLSXP :
+        src[j] = DATAPTR_RO(thiscol);  // copied in parallel below, once all input columns are ready
+        break;
+      default :
+        error(_("Unknown column type '%s' for column '%s'."), type2char(TYPEOF(thiscol)), CHAR(STRING_ELT(dtnames, INTEGER(thisvaluecols)[j]-1)));
       }
       UNPROTECT(thisprotecti);  // inside inner loop (note that it's double loop) so as to limit use of protection stack
     }
+    switch (TYPEOF(target)) {
+    case REALSXP : meltcopy(REAL(target), src, sizeof(double), data); break;
+    case INTSXP :
+    case LGLSXP : meltcopy(INTEGER(target), src, sizeof(int), data); break;
+    default : break;
+    }
+    for (int j=0; j<data->lmax; ++j) SET_VECTOR_ELT(srccols, j, R_NilValue);
     if (thisvalfactor && data->isfactor[i] && TYPEOF(target) != VECSXP) {
       SET_VECTOR_ELT(ansvals, i, combineFactorLevels(flevels, target, &(data->isfactor[i]), isordered));
     }
   }
-  UNPROTECT(2);  // flevels, ansvals. Not using two protection counters (protecti and thisprotecti) to keep rchk happy.
+  UNPROTECT(3);  // flevels, ansvals, srccols. Not using two protection counters (protecti and thisprotecti) to keep rchk happy.
   return(ansvals);
 }
 
@@ -603,16 +730,18 @@ SEXP getvarcols(SEXP DT, SEXP dtnames, Rboolean varfactor, Rboolean verbose, str
       if (!data->measure_is_list) {//one value column to output.
         const int *thisvaluecols = INTEGER(VECTOR_ELT(data->valuecols, 0));
         for (int j=0, ansloc=0; j<data->lmax; ++j) {
-          const int thislen = data->narm ? length(VECTOR_ELT(data->not_NA_indices, j)) : data->nrow;
+          const int thislen = outlen(data, j);
           SEXP str = STRING_ELT(dtnames, thisvaluecols[j]-1);
           for (int k=0; k<thislen; ++k) SET_STRING_ELT(target, ansloc++, str);
         }
       } else {//multiple value columns to output.
         for (int j=0, ansloc=0, level=1; j<data->lmax; ++j) {
-          const int thislen = data->narm ? length(VECTOR_ELT(data->not_NA_indices, j)) : data->nrow;
+          const int thislen = outlen(data, j);
           char buff[20];
           snprintf(buff, sizeof(buff), "%d", level++); // # notranslate
-          for (int k=0; k<thislen; ++k) SET_STRING_ELT(target, ansloc++, mkChar(buff));
+          SEXP str = PROTECT(mkChar(buff));
+          for (int k=0; k<thislen; ++k) SET_STRING_ELT(target, ansloc++, str);
+          UNPROTECT(1);
         }
       }
     } else {// varfactor==TRUE
@@ -629,7 +758,7 @@ SEXP getvarcols(SEXP DT, SEXP dtnames, Rboolean varfactor, Rboolean verbose, str
         int numRemove = 0;  // remove dups and any for which narm and all-NA
         int *md = INTEGER(m);
         for (int j=0; j<len; ++j) {
-          if (md[j]!=j+1 /*dup*/ || (data->narm && length(VECTOR_ELT(data->not_NA_indices, j))==0)) { numRemove++; md[j]=0; }
+          if (md[j]!=j+1 /*dup*/ || (data->narm && outlen(data, j)==0)) { numRemove++; md[j]=0; }
         }
         if (numRemove) {
           SEXP newlevels = PROTECT(allocVector(STRSXP, len-numRemove)); protecti++;
@@ -638,20 +767,17 @@ SEXP getvarcols(SEXP DT, SEXP dtnames, Rboolean varfactor, Rboolean verbose, str
           md = INTEGER(m);
           levels = newlevels;
         }
-        for (int j=0, ansloc=0; j<data->lmax; ++j) {
-          const int thislen = data->narm ? length(VECTOR_ELT(data->not_NA_indices, j)) : data->nrow;
-          for (int k=0; k<thislen; ++k) td[ansloc++] = md[j];
-        }
+        meltfill(td, md, sizeof(int), data);
       } else {//multiple output columns.
-        int nlevel=0;
         levels = PROTECT(allocVector(STRSXP, data->lmax)); protecti++;
-        for (int j=0, ansloc=0; j<data->lmax; ++j) {
-          const int thislen = data->narm ? length(VECTOR_ELT(data->not_NA_indices, j)) : data->nrow;
+        int *level = (int *)R_alloc(data->lmax, sizeof(*level));
+        for (int j=0; j<data->lmax; ++j) {
           char buff[20];
-          snprintf(buff, sizeof(buff), "%d", nlevel + 1); // # notranslate
-          SET_STRING_ELT(levels, nlevel++, mkChar(buff));  // generate levels = 1:nlevels
-          for (int k=0; k<thislen; ++k) td[ansloc++] = nlevel;
+          snprintf(buff, sizeof(buff), "%d", j + 1); // # notranslate
+          SET_STRING_ELT(levels, j, mkChar(buff));  // generate levels = 1:nlevels
+          level[j] = j + 1;
         }
+        meltfill(td, level, sizeof(int), data);
       }
       setAttrib(target, R_LevelsSymbol, levels);
       setAttrib(target, R_ClassSymbol, ScalarString(char_factor));
@@ -660,30 +786,28 @@ SEXP getvarcols(SEXP DT, SEXP dtnames, Rboolean varfactor, Rboolean verbose, str
     for (int out_col_i=0; out_col_i<data->lvars; ++out_col_i) {
       SEXP out_col = VECTOR_ELT(data->variable_table, out_col_i);
       SET_VECTOR_ELT(ansvars, out_col_i, target=allocVector(TYPEOF(out_col), data->totlen));
-      for (int j=0, ansloc=0; j<data->lmax; ++j) {
-        const int thislen = data->narm ? length(VECTOR_ELT(data->not_NA_indices, j)) : data->nrow;
-        switch (TYPEOF(target)) {
-        case STRSXP :
+      switch (TYPEOF(target)) {
+      case STRSXP :
+        for (int j=0, ansloc=0; j<data->lmax; ++j) {
+          const int thislen = outlen(data, j);
           for (int k=0; k<thislen; ++k)
             SET_STRING_ELT(target, ansloc++, STRING_ELT(out_col, j));
-          break;
-        case REALSXP :
-          for (int k=0; k<thislen; ++k)
-            REAL(target)[ansloc++] = REAL(out_col)[j];
-          break;
-        case INTSXP :
-        case LGLSXP :
-          for (int k=0; k<thislen; ++k)
-            INTEGER(target)[ansloc++] = INTEGER(out_col)[j];
-          if (isFactor(out_col)) {
-            // Do we need a copy here?
-            setAttrib(target, R_LevelsSymbol, getAttrib(out_col, R_LevelsSymbol));
-            setAttrib(target, R_ClassSymbol, ScalarString(char_factor));
-          }
-          break;
-        default :
-          error(_("variable_table does not support column type '%s' for column '%s'."), type2char(TYPEOF(out_col)), CHAR(STRING_ELT(getAttrib(data->variable_table, R_NamesSymbol), out_col_i)));
         }
+        break;
+      case REALSXP :
+        meltfill(REAL(target), REAL_RO(out_col), sizeof(double), data);
+        break;
+      case INTSXP :
+      case LGLSXP :
+        meltfill(INTEGER(target), INTEGER_RO(out_col), sizeof(int), data);
+        if (isFactor(out_col)) {
+          // Do we need a copy here?
+          setAttrib(target, R_LevelsSymbol, getAttrib(out_col, R_LevelsSymbol));
+          setAttrib(target, R_ClassSymbol, ScalarString(char_factor));
+        }
+        break;
+      default :
+        error(_("variable_table does not support column type '%s' for column '%s'."), type2char(TYPEOF(out_col)), CHAR(STRING_ELT(getAttrib(data->variable_table, R_NamesSymbol), out_col_i)));
       }
     }
   }
@@ -693,89 +817,35 @@ SEXP getvarcols(SEXP DT, SEXP dtnames, Rboolean varfactor, Rboolean verbose, str
 
 SEXP getidcols(SEXP DT, SEXP dtnames, Rboolean verbose, struct processData *data) {
   SEXP ansids = PROTECT(allocVector(VECSXP, data->lids));
+  const void **src = (const void **)R_alloc(data->lmax, sizeof(*src));
   for (int i=0; i<data->lids; ++i) {
-    int counter = 0;
     SEXP thiscol = VECTOR_ELT(DT, INTEGER(data->idcols)[i]-1);
     size_t size = RTYPE_SIZEOF(thiscol);
     SEXP target;
     SET_VECTOR_ELT(ansids, i, target=allocVector(TYPEOF(thiscol), data->totlen) );
     copyMostAttrib(thiscol, target); // all but names,dim and dimnames. And if so, we want a copy here, not keepattr's SET_ATTRIB.
     switch(TYPEOF(thiscol)) {
-    case REALSXP : {
-      double *dtarget = REAL(target);
-      const double *dthiscol = REAL_RO(thiscol);
-      if (data->narm) {
-        for (int j=0; j<data->lmax; ++j) {
-          SEXP thisidx = VECTOR_ELT(data->not_NA_indices, j);
-          const int *ithisidx = INTEGER(thisidx);
-          const int thislen = length(thisidx);
-          for (int k=0; k<thislen; ++k)
-            dtarget[counter + k] = dthiscol[ithisidx[k]-1];
-          counter += thislen;
-        }
-      } else if (data->nrow) {
-        for (int j=0; j<data->lmax; ++j)
-          memcpy(dtarget + j*data->nrow, dthiscol, data->nrow*size);
-      }
-    }
-      break;
+    case REALSXP :
     case INTSXP :
     case LGLSXP : {
-      int *itarget = INTEGER(target);
-      const int *ithiscol = INTEGER_RO(thiscol);
-      if (data->narm) {
-        for (int j=0; j<data->lmax; ++j) {
-          SEXP thisidx = VECTOR_ELT(data->not_NA_indices, j);
-          const int *ithisidx = INTEGER(thisidx);
-          const int thislen = length(thisidx);
-          for (int k=0; k<thislen; ++k)
-            itarget[counter + k] = ithiscol[ithisidx[k]-1];
-          counter += thislen;
-        }
-      } else if (data->nrow) {
-        for (int j=0; j<data->lmax; ++j)
-          memcpy(itarget + j*data->nrow, ithiscol, data->nrow*size);
-      }
+      // the id column is repeated once for each input column by block memcpy, all in parallel
+      const void *p = DATAPTR_RO(thiscol);
+      for (int j=0; j<data->lmax; ++j) src[j] = p;
+      meltcopy(TYPEOF(target)==REALSXP ? (void *)REAL(target) : (void *)INTEGER(target), src, size, data);
     } break;
     case STRSXP : {
-      if (data->narm) {
-        for (int j=0; j<data->lmax; ++j) {
-          SEXP thisidx = VECTOR_ELT(data->not_NA_indices, j);
-          const int *ithisidx = INTEGER(thisidx);
-          const int thislen = length(thisidx);
-          for (int k=0; k<thislen; ++k)
-            SET_STRING_ELT(target, counter + k, STRING_ELT(thiscol, ithisidx[k]-1));
-          counter += thislen;
-        }
-      } else {
-        const SEXP *s = STRING_PTR_RO(thiscol);  // to reduce overhead of STRING_ELT() inside loop below. Read-only hence const.
-        for (int j=0; j<data->lmax; ++j) {
-          for (int k=0; k<data->nrow; ++k) {
-            SET_STRING_ELT(target, j*data->nrow + k, s[k]);
-          }
-        }
+      const SEXP *s = STRING_PTR_RO(thiscol);  // to reduce overhead of STRING_ELT() inside loop below. Read-only hence const.
+      for (int j=0; j<data->lmax; ++j) {
+        int64_t pos = outstart(data, j);
+        for (int k=0; k<data->nrow; ++k) if (iskept(data, j, k)) SET_STRING_ELT(target, pos++, s[k]);
       }
-    }
-      break;
+    } break;
     case VECSXP : {
-      if (data->narm) {
-        for (int j=0; j<data->lmax; ++j) {
-          SEXP thisidx = VECTOR_ELT(data->not_NA_indices, j);
-          const int *ithisidx = INTEGER(thisidx);
-          const int thislen = length(thisidx);
-          for (int k=0; k<thislen; ++k)
-            SET_VECTOR_ELT(target, counter + k, VECTOR_ELT(thiscol, ithisidx[k]-1));
-          counter += thislen;
-        }
-      } else {
-        for (int j=0; j<data->lmax; ++j) {
-          for (int k=0; k<data->nrow; ++k) {
-            SET_VECTOR_ELT(target, j*data->nrow + k, VECTOR_ELT(thiscol, k));
-          }
-        }
+      for (int j=0; j<data->lmax; ++j) {
+        int64_t pos = outstart(data, j);
+        for (int k=0; k<data->nrow; ++k) if (iskept(data, j, k)) SET_VECTOR_ELT(target, pos++, VECTOR_ELT(thiscol, k));
       }
-    }
-      break;
+    } break;
     default : error(_("Unknown column type '%s' for column '%s' in 'data'"), type2char(TYPEOF(thiscol)), CHAR(STRING_ELT(dtnames, INTEGER(data->idcols)[i]-1)));
     }
   }
@@ -807,7 +877,7 @@ SEXP fmelt(SEXP DT, SEXP id, SEXP measure, SEXP varfactor, SEXP valfactor, SEXP
   if (LOGICAL(narmArg)[0] == TRUE) narm = TRUE;
   if (LOGICAL(verboseArg)[0] == TRUE) verbose = TRUE;
   struct processData data;
-  data.RCHK = PROTECT(allocVector(VECSXP, 2)); protecti++;
+  data.RCHK = PROTECT(allocVector(VECSXP, 1)); protecti++;
   preprocess(DT, id, measure, varnames, valnames, narm, verbose, &data);
   // edge case no measure.vars
   if (!data.lmax) {
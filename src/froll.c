@@ -18,8 +18,9 @@
  *   adding/removing in/out of sliding window of observations
  * algo = 1: exact
  *   recalculate whole fun for each observation, for mean roundoff correction is adjusted
+ * p is the probability of quantile
  */
-void frollfun(rollfun_t rfun, unsigned int algo, const double *x, uint64_t nx, ans_t *ans, int k, int align, double fill, bool narm, int hasnf, bool verbose, bool par) {
+void frollfun(rollfun_t rfun, unsigned int algo, const double *x, uint64_t nx, ans_t *ans, int k, int align, double fill, bool narm, int hasnf, double p, bool verbose, bool par) {
   double tic = 0;
   if (verbose)
     tic = omp_get_wtime();
@@ -89,10 +90,13 @@ void frollfun(rollfun_t rfun, unsigned int algo, const double *x, uint64_t nx, a
       frollsdExact(x, nx, ans, k, fill, narm, hasnf, verbose);
     }
     break;
+  case QUANTILE : case SKEW : case KURT : case RANK : case UNIQUEN : // see frollstat.c, rank ranks the observation the window is aligned to
+    frollfunStat(rfun, algo, x, nx, ans, k, NULL, align==1 ? k-1 : align==-1 ? 0 : k-1-k/2, p, fill, narm, hasnf, verbose, par);
+    break;
   default: // # nocov
     internal_error(__func__, "Unknown rfun value in froll: %d", rfun); // # nocov
   }
-  if (align < 1 && ans->status < 3) {
+  if (align < 1 && k > 0 && ans->status < 3) { // nothing to shift for window of size 0
     int k_ = align==-1 ? k-1 : floor(k/2);       // offset to shift
     if (verbose)
       snprintf(end(ans->message[0]), 500, _("%s: align %d, shift answer by %d\n"), __func__, align, -k_);
@@ -105,6 +109,45 @@ void frollfun(rollfun_t rfun, unsigned int algo, const double *x, uint64_t nx, a
     snprintf(end(ans->message[0]), 500, _("%s: processing fun %d algo %u took %.3fs\n"), __func__, rfun, algo, omp_get_wtime()-tic);
 }
 
+/* grouped rolling fun - each group is rolled on its own, as if x was split by group, in one parallel sweep over groups
+ * groups are contiguous in x and in ans->dbl_v: group g is rows gs[g] to gs[g]+gl[g]-1
+ * k is the window, or when ka is not NULL, ka is the adaptive window of each row of x
+ * each thread reuses one ans_t pointing into ans->dbl_v for its groups, rather than one per group; verbose output of
+ *   each group is not collected, warnings and errors are kept from the first group that raised them
+ * xtype of x is 0 double, 1 integer or 2 integer64, the latter two are rolled by frollfunInt
+ */
+void frollfunGrouped(rollfun_t rfun, unsigned int algo, const void *x, int xtype, ans_t *ans, const int *gs, const int *gl, int ngrp, int k, const int *ka, int align, double fill, int64_t i64fill, bool narm, int hasnf, double p) {
+  int nth = getDTthreads(ngrp, true);
+  ans_t *tans = (ans_t *)R_alloc(nth, sizeof(*tans));
+  #pragma omp parallel for schedule(dynamic, 256) num_threads(nth)
+  for (int g=0; g<ngrp; g++) {
+    ans_t *t = &tans[omp_get_thread_num()];
+    t->dbl_v = ans->dbl_v + gs[g];
+    t->int64_v = (int64_t *)t->dbl_v;
+    t->status = 0;
+    for (int s=0; s<4; s++) t->message[s][0] = '\0';
+    if (xtype) {
+      const void *xg = xtype==2 ? (const void *)((const int64_t *)x+gs[g]) : (const void *)((const int *)x+gs[g]);
+      frollfunInt(rfun, algo, xg, xtype==2, gl[g], t, k, ka ? ka+gs[g] : NULL, align, fill, i64fill, narm, hasnf, /*verbose=*/false, /*par=*/false);
+    } else if (ka) {
+      frolladaptivefun(rfun, algo, (const double *)x+gs[g], gl[g], t, ka+gs[g], fill, narm, hasnf, p, /*verbose=*/false);
+    } else {
+      frollfun(rfun, algo, (const double *)x+gs[g], gl[g], t, k, align, fill, narm, hasnf, p, /*verbose=*/false, /*par=*/false);
+    }
+    if (t->status) {
+      #pragma omp critical
+      {
+        for (int s=1; s<4; s++) {
+          if (t->message[s][0]!='\0' && ans->message[s][0]=='\0')
+            strcpy(ans->message[s], t->message[s]);
+        }
+        if (t->status > ans->status)
+          ans->status = t->status;
+      }
+    }
+  }
+}
+
 #undef SUM_WINDOW_STEP_FRONT
 #define SUM_WINDOW_STEP_FRONT                                  \
   if (R_FINITE(x[i])) {                                        \
@@ -1845,3 +1888,52 @@ void frollmedianExact(const double *x, uint64_t nx, ans_t *ans, int k, double fi
   }
   free(xx);
 }
+
+/* adaptive window width of each observation for a window spanning n of a sorted index, e.g. the last 5 minutes
+ * align right: window of i are observations j<=i having idx[j] > idx[i]-n
+ * align left: window of i are observations j>=i having idx[j] < idx[i]+n
+ * two pointer sweep where the other end of the window only moves forward, so it is linear in nx
+ * the series is split into one chunk per thread, each chunk finds where its first window ends by binary search, and so
+ *   chunks overlap by at most one window
+ * !partial: a window reaching before the first (align left: after the last) index value is given a width bigger than
+ *   number of observations it can have, so that adaptive rolling function fills it, as frolladapt does
+ */
+void frollindexwidth(const double *idx, uint64_t nx, double n, bool left, bool partial, int *k) {
+  if (!nx)
+    return;
+  int nth = getDTthreads(nx, true);
+  const uint64_t chunk = (nx + nth - 1) / nth;
+  const double first = idx[0], last = idx[nx-1];
+  #pragma omp parallel for num_threads(nth)
+  for (int c=0; c<nth; c++) {
+    const uint64_t from = c*chunk, to = MIN(from+chunk, nx);
+    if (from >= to)
+      continue;
+    if (!left) {
+      uint64_t lo = 0, hi = from;                                   // first j with idx[j] > idx[from]-n
+      const double b = idx[from]-n;
+      while (lo < hi) {
+        const uint64_t mid = lo + (hi-lo)/2;
+        if (idx[mid] > b) hi = mid; else lo = mid+1;
+      }
+      for (uint64_t i=from; i<to; i++) {
+        const double bi = idx[i]-n;
+        while (lo <= i && idx[lo] <= bi) lo++;
+        k[i] = (!partial && bi < first) ? i+2 : i+1-lo;
+      }
+    } else {
+      uint64_t lo = from, hi = nx;                                  // first j with idx[j] >= idx[from]+n
+      const double b = idx[from]+n;
+      while (lo < hi) {
+        const uint64_t mid = lo + (hi-lo)/2;
+        if (idx[mid] >= b) hi = mid; else lo = mid+1;
+      }
+      for (uint64_t i=from; i<to; i++) {
+        const double bi = idx[i]+n;
+        if (lo < i) lo = i;                                         // n==0 and ties
+        while (lo < nx && idx[lo] < bi) lo++;
+        k[i] = (!partial && bi > last) ? nx-i+1 : lo-i;
+      }
+    }
+  }
+}
@@ -2,8 +2,9 @@
 #include <Rdefines.h>
 
 // validate and coerce to list of real
-SEXP coerceX(SEXP obj) {
+SEXP coerceX(SEXP obj, bool intok) {
   // accept atomic/list of integer/logical/real returns list of real
+  // intok: integer, logical and integer64 are returned as-is, for funs that roll them natively, see frollint.c
   int protecti = 0;
   if (isVectorAtomic(obj)) {
     SEXP obj1 = obj;
@@ -16,6 +17,10 @@ SEXP coerceX(SEXP obj) {
     SEXP this_obj = VECTOR_ELT(obj, i);
     if (!(isReal(this_obj) || isInteger(this_obj) || isLogical(this_obj)))
       error(_("'x' must be of type numeric or logical, or a list, data.frame or data.table of such"));
+    if (intok && (!isReal(this_obj) || INHERITS(this_obj, char_integer64))) {
+      SET_VECTOR_ELT(x, i, this_obj);
+      continue;
+    }
     SET_VECTOR_ELT(x, i, coerceAs(this_obj, PROTECT(ScalarReal(NA_REAL)), /*copyArg=*/ScalarLogical(false))); // copyArg=false will make type-class match to return as-is, no copy
     UNPROTECT(1); // as= input to coerceAs()
   }
@@ -78,7 +83,9 @@ SEXP coerceK(SEXP obj, bool adaptive) {
   return ans;
 }
 
-SEXP frollfunR(SEXP fun, SEXP xobj, SEXP kobj, SEXP fill, SEXP algo, SEXP align, SEXP narm, SEXP hasnf, SEXP adaptive) {
+// grp is NULL, or list(starts, lens) of contiguous groups of rows (starts 0-based) for gfroll() in gsumm.c which has
+// already gathered x (and adaptive n) into group order; each group is then rolled on its own, see frollfunGrouped
+SEXP frollfunR(SEXP fun, SEXP xobj, SEXP kobj, SEXP fill, SEXP algo, SEXP align, SEXP narm, SEXP hasnf, SEXP adaptive, SEXP p, SEXP grp) {
   int protecti = 0;
   const bool verbose = GetVerbose();
 
@@ -87,7 +94,39 @@ SEXP frollfunR(SEXP fun, SEXP xobj, SEXP kobj, SEXP fill, SEXP algo, SEXP align,
   double tic = 0;
   if (verbose)
     tic = omp_get_wtime();
-  SEXP x = PROTECT(coerceX(xobj)); protecti++;
+  rollfun_t rfun = MEAN; // adding fun needs to be here and data.table.h, initialize to keep compiler happy
+  if (!strcmp(CHAR(STRING_ELT(fun, 0)), "mean")) {
+    rfun = MEAN;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "sum")) {
+    rfun = SUM;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "max")) {
+    rfun = MAX;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "min")) {
+    rfun = MIN;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "prod")) {
+    rfun = PROD;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "median")) {
+    rfun = MEDIAN;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "var")) {
+    rfun = VAR;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "sd")) {
+    rfun = SD;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "quantile")) {
+    rfun = QUANTILE;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "skew")) {
+    rfun = SKEW;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "kurt")) {
+    rfun = KURT;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "rank")) {
+    rfun = RANK;
+  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "uniqueN")) {
+    rfun = UNIQUEN;
+  } else {
+    internal_error(__func__, "invalid %s argument in %s function should have been caught earlier", "fun", "rolling"); // # nocov
+  }
+
+  const bool intok = rfun==SUM || rfun==MAX || rfun==MIN || rfun==PROD; // rolled natively on integer and integer64, without a double copy
+  SEXP x = PROTECT(coerceX(xobj, intok)); protecti++;
   R_len_t nx = length(x);                                       // number of columns to roll on
 
   if (xlength(kobj) == 0)                                       // check that window is non zero length
@@ -133,10 +172,13 @@ SEXP frollfunR(SEXP fun, SEXP xobj, SEXP kobj, SEXP fill, SEXP algo, SEXP align,
   if (verbose)
     Rprintf(_("%s: allocating memory for results %dx%d\n"), __func__, nx, nk);
   ans_t *dans = (ans_t *)R_alloc(nx*nk, sizeof(*dans));         // answer columns as array of ans_t struct
-  const double** dx = (const double**)R_alloc(nx, sizeof(*dx));  // pointers to source columns
+  const void** dx = (const void**)R_alloc(nx, sizeof(*dx));      // pointers to source columns
+  int *xtype = (int *)R_alloc(nx, sizeof(*xtype));              // 0 double, 1 integer or logical, 2 integer64
   uint64_t* inx = (uint64_t*)R_alloc(nx, sizeof(*inx));         // to not recalculate `length(x[[i]])` we store it in extra array
   for (R_len_t i=0; i<nx; i++) {
-    inx[i] = xlength(VECTOR_ELT(x, i));                         // for list input each vector can have different length
+    SEXP xi = VECTOR_ELT(x, i);
+    xtype[i] = !isReal(xi) ? 1 : INHERITS(xi, char_integer64) ? 2 : 0;
+    inx[i] = xlength(xi);                                       // for list input each vector can have different length
     for (R_len_t j=0; j<nk; j++) {
       if (badaptive) {                                          // extra input validation
         if (i > 0 && (inx[i]!=inx[i-1]))                        // variable length list input not allowed for adaptive roll
@@ -144,31 +186,13 @@ SEXP frollfunR(SEXP fun, SEXP xobj, SEXP kobj, SEXP fill, SEXP algo, SEXP align,
         if (xlength(VECTOR_ELT(k, j))!=inx[0])                 // check that length of integer vectors in n list match to xrows[0] ([0] and not [i] because there is above check for equal xrows)
           error(_("length of integer vector(s) provided as list to 'n' argument must be equal to number of observations provided in 'x'"));
       }
-      SET_VECTOR_ELT(ans, i*nk+j, allocVector(REALSXP, inx[i]));// allocate answer vector for this column-window
-      dans[i*nk+j] = ((ans_t) { .dbl_v=REAL(VECTOR_ELT(ans, i*nk+j)), .status=0, .message={"\0","\0","\0","\0"} });
+      SEXP ansij = allocVector(REALSXP, inx[i]);                // allocate answer vector for this column-window
+      SET_VECTOR_ELT(ans, i*nk+j, ansij);
+      if (xtype[i]==2)
+        setAttrib(ansij, R_ClassSymbol, ScalarString(char_integer64));
+      dans[i*nk+j] = ((ans_t) { .dbl_v=REAL(ansij), .int64_v=(int64_t *)REAL(ansij), .status=0, .message={"\0","\0","\0","\0"} });
     }
-    dx[i] = REAL_RO(VECTOR_ELT(x, i));                             // assign source columns to C pointers
-  }
-
-  rollfun_t rfun = MEAN; // adding fun needs to be here and data.table.h, initialize to keep compiler happy
-  if (!strcmp(CHAR(STRING_ELT(fun, 0)), "mean")) {
-    rfun = MEAN;
-  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "sum")) {
-    rfun = SUM;
-  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "max")) {
-    rfun = MAX;
-  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "min")) {
-    rfun = MIN;
-  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "prod")) {
-    rfun = PROD;
-  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "median")) {
-    rfun = MEDIAN;
-  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "var")) {
-    rfun = VAR;
-  } else if (!strcmp(CHAR(STRING_ELT(fun, 0)), "sd")) {
-    rfun = SD;
-  } else {
-    internal_error(__func__, "invalid %s argument in %s function should have been caught earlier", "fun", "rolling"); // # nocov
+    dx[i] = xtype[i]==1 ? (const void *)INTEGER_RO(xi) : (const void *)REAL_RO(xi); // assign source columns to C pointers
   }
 
   if (length(fill) != 1)
@@ -177,9 +201,26 @@ SEXP frollfunR(SEXP fun, SEXP xobj, SEXP kobj, SEXP fill, SEXP algo, SEXP align,
     error(_("fill must be numeric or logical"));
   double dfill = REAL(PROTECT(coerceAs(fill, PROTECT(ScalarReal(NA_REAL)), ScalarLogical(true))))[0]; protecti++;
   UNPROTECT(1); // as= input to coerceAs()
+  int64_t i64fill = NA_INTEGER64;                               // fill of integer64 answer, needs integer64 rather than double for exactness
+  for (R_len_t i=0; i<nx; i++) {
+    if (xtype[i]==2) {
+      i64fill = ((int64_t *)REAL(PROTECT(coerceAs(fill, VECTOR_ELT(x, i), ScalarLogical(true)))))[0];
+      UNPROTECT(1);
+      break;
+    }
+  }
 
   bool bnarm = LOGICAL(narm)[0];
 
+  double dp = 0.5;                                              // probability of quantile
+  if (rfun==QUANTILE) {
+    if (length(p)!=1 || !(isReal(p) || isInteger(p)))
+      error(_("'p' must be a single number between 0 and 1"));
+    dp = isReal(p) ? REAL(p)[0] : INTEGER(p)[0]==NA_INTEGER ? NA_REAL : INTEGER(p)[0];
+    if (!(dp >= 0 && dp <= 1))                                  // also NA
+      error(_("'p' must be a single number between 0 and 1"));
+  }
+
   int ihasnf =                                                  // plain C tri-state boolean as integer
     LOGICAL(hasnf)[0]==NA_LOGICAL ? 0 :                         // hasnf NA, default, no info about NA
     LOGICAL(hasnf)[0]==TRUE ? 1 :                               // hasnf TRUE, might be some NAs
@@ -193,9 +234,25 @@ SEXP frollfunR(SEXP fun, SEXP xobj, SEXP kobj, SEXP fill, SEXP algo, SEXP align,
   else
     internal_error(__func__, "invalid %s argument in %s function should have been caught earlier", "algo", "rolling"); // # nocov
 
-  bool par = nx*nk>1 && ialgo==0;
+  const int *gs = NULL, *gl = NULL;
+  int ngrp = 0;
+  if (!isNull(grp)) {
+    if (!isNewList(grp) || length(grp)!=2 || !isInteger(VECTOR_ELT(grp, 0)) || !isInteger(VECTOR_ELT(grp, 1)) || length(VECTOR_ELT(grp, 0))!=length(VECTOR_ELT(grp, 1)))
+      internal_error(__func__, "grp must be NULL or a list of two integer vectors of equal length"); // # nocov
+    gs = INTEGER_RO(VECTOR_ELT(grp, 0));
+    gl = INTEGER_RO(VECTOR_ELT(grp, 1));
+    ngrp = length(VECTOR_ELT(grp, 0));
+    int64_t grpn = 0;
+    for (int g=0; g<ngrp; g++) grpn += gl[g];
+    for (R_len_t i=0; i<nx; i++) if (inx[i]!=grpn)
+      internal_error(__func__, "groups cover %"PRId64" rows but column %d has %"PRIu64" rows", grpn, i+1, inx[i]); // # nocov
+  }
+
+  bool par = nx*nk>1 && ialgo==0 && !gs;
   if (verbose) {
-    if (par) {
+    if (gs) {
+      Rprintf(_("%s: computing %d column(s) and %d window(s) for each of %d groups, in parallel over groups\n"), __func__, nx, nk, ngrp);
+    } else if (par) {
       Rprintf(_("%s: computing %d column(s) and %d window(s) in parallel\n"), __func__, nx, nk);
     } else if (ialgo==1) {
       Rprintf(_("%s: computing %d column(s) and %d window(s) sequentially because algo='exact' is already parallelised within each rolling computation\n"), __func__, nx, nk);
@@ -203,13 +260,23 @@ SEXP frollfunR(SEXP fun, SEXP xobj, SEXP kobj, SEXP fill, SEXP algo, SEXP align,
       Rprintf(_("%s: computing %d column(s) and %d window(s) sequentially as there is only single rolling computation\n"), __func__, nx, nk);
     }
   }
-  #pragma omp parallel for if (par) schedule(dynamic) collapse(2) num_threads(getDTthreads(nx*nk, false))
-  for (R_len_t i=0; i<nx; i++) {                                // loop over multiple columns
-    for (R_len_t j=0; j<nk; j++) {                              // loop over multiple windows
-      if (!badaptive) {
-        frollfun(rfun, ialgo, dx[i], inx[i], &dans[i*nk+j], ik[j], ialign, dfill, bnarm, ihasnf, verbose, /*par=*/!par); // par tells medianFast if it can use openmp so we avoid nested parallelism
-      } else {
-        frolladaptivefun(rfun, ialgo, dx[i], inx[i], &dans[i*nk+j], lk[j], dfill, bnarm, ihasnf, verbose);
+  if (gs) {
+    for (R_len_t i=0; i<nx; i++) {
+      for (R_len_t j=0; j<nk; j++) {
+        frollfunGrouped(rfun, ialgo, dx[i], xtype[i], &dans[i*nk+j], gs, gl, ngrp, badaptive ? 0 : ik[j], badaptive ? lk[j] : NULL, ialign, dfill, i64fill, bnarm, ihasnf, dp);
+      }
+    }
+  } else {
+    #pragma omp parallel for if (par) schedule(dynamic) collapse(2) num_threads(getDTthreads(nx*nk, false))
+    for (R_len_t i=0; i<nx; i++) {                                // loop over multiple columns
+      for (R_len_t j=0; j<nk; j++) {                              // loop over multiple windows
+        if (xtype[i]) {
+          frollfunInt(rfun, ialgo, dx[i], xtype[i]==2, inx[i], &dans[i*nk+j], badaptive ? 0 : ik[j], badaptive ? lk[j] : NULL, ialign, dfill, i64fill, bnarm, ihasnf, verbose, /*par=*/!par);
+        } else if (!badaptive) {
+          frollfun(rfun, ialgo, dx[i], inx[i], &dans[i*nk+j], ik[j], ialign, dfill, bnarm, ihasnf, dp, verbose, /*par=*/!par); // par tells medianFast if it can use openmp so we avoid nested parallelism
+        } else {
+          frolladaptivefun(rfun, ialgo, dx[i], inx[i], &dans[i*nk+j], lk[j], dfill, bnarm, ihasnf, dp, verbose);
+        }
       }
     }
   }
@@ -281,3 +348,24 @@ SEXP frolladapt(SEXP xobj, SEXP kobj, SEXP partial) {
   UNPROTECT(1);
   return ans;
 }
+
+// helper called from R to generate adaptive window for a window spanning n of a sorted index, see frollindexwidth
+SEXP frollindex(SEXP index, SEXP nobj, SEXP align, SEXP partial) {
+  if (!isReal(index) && !isInteger(index))
+    error(_("'index' must be of a numeric type"));
+  if (!isReal(nobj) || length(nobj)!=1 || !R_FINITE(REAL(nobj)[0]) || REAL(nobj)[0] < 0)
+    error(_("'n' must be a single non-negative finite number when 'index' is used"));
+  if (!IS_TRUE_OR_FALSE(partial))
+    error(_("%s must be TRUE or FALSE"), "partial");
+  int64_t len = XLENGTH(index);
+  SEXP idx = PROTECT(coerceAs(index, PROTECT(ScalarReal(NA_REAL)), /*copyArg=*/ScalarLogical(false))); // int index to double, double as-is
+  const double *didx = REAL_RO(idx);
+  for (int64_t i=0; i<len; i++) {
+    if (ISNAN(didx[i]) || (i && didx[i] < didx[i-1]))
+      error(_("'index' must be sorted in increasing order and have no NAs"));
+  }
+  SEXP ans = PROTECT(allocVector(INTSXP, len));
+  frollindexwidth(didx, len, REAL(nobj)[0], !strcmp(CHAR(STRING_ELT(align, 0)), "left"), LOGICAL(partial)[0], INTEGER(ans));
+  UNPROTECT(3);
+  return ans;
+}
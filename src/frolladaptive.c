@@ -7,7 +7,7 @@
  * algo = 1: exact
  *   recalculate whole fun for each observation, for mean roundoff correction is adjusted
  */
-void frolladaptivefun(rollfun_t rfun, unsigned int algo, const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose) {
+void frolladaptivefun(rollfun_t rfun, unsigned int algo, const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, double p, bool verbose) {
   double tic = 0;
   if (verbose)
     tic = omp_get_wtime();
@@ -27,18 +27,18 @@ void frolladaptivefun(rollfun_t rfun, unsigned int algo, const double *x, uint64
     }
     break;
   case MAX :
-    if (algo==0 && verbose) {
-      //frolladaptivemaxFast(x, nx, ans, k, fill, narm, hasnf, verbose); // frolladaptivemaxFast does not exists as of now
-      snprintf(end(ans->message[0]), 500, _("%s: algo %u not implemented, fall back to %u\n"), __func__, algo, (unsigned int) 1);
+    if (algo==0) {
+      frolladaptivemaxFast(x, nx, ans, k, fill, narm, hasnf, verbose);
+    } else if (algo==1) {
+      frolladaptivemaxExact(x, nx, ans, k, fill, narm, hasnf, verbose);
     }
-    frolladaptivemaxExact(x, nx, ans, k, fill, narm, hasnf, verbose);
     break;
   case MIN :
-    if (algo==0 && verbose) {
-      //frolladaptiveminFast(x, nx, ans, k, fill, narm, hasnf, verbose); // frolladaptiveminFast does not exists as of now
-      snprintf(end(ans->message[0]), 500, _("%s: algo %u not implemented, fall back to %u\n"), __func__, algo, (unsigned int) 1);
+    if (algo==0) {
+      frolladaptiveminFast(x, nx, ans, k, fill, narm, hasnf, verbose);
+    } else if (algo==1) {
+      frolladaptiveminExact(x, nx, ans, k, fill, narm, hasnf, verbose);
     }
-    frolladaptiveminExact(x, nx, ans, k, fill, narm, hasnf, verbose);
     break;
   case PROD :
     if (algo==0 && verbose) {
@@ -68,6 +68,9 @@ void frolladaptivefun(rollfun_t rfun, unsigned int algo, const double *x, uint64
     }
     frolladaptivesdExact(x, nx, ans, k, fill, narm, hasnf, verbose);
     break;
+  case QUANTILE : case SKEW : case KURT : case RANK : case UNIQUEN :
+    frollfunStat(rfun, algo, x, nx, ans, 0, k, 0, p, fill, narm, hasnf, verbose, /*par=*/false); // see frollstat.c
+    break;
   default: // # nocov
     internal_error(__func__, "Unknown rfun value in frolladaptive: %d", rfun); // # nocov
   }
@@ -504,6 +507,76 @@ void frolladaptivesumExact(const double *x, uint64_t nx, ans_t *ans, const int *
   }
 }
 
+/* fast rolling adaptive max/min - fast
+ * monotonic deque of indices whose values are decreasing (max) or increasing (min): each new observation drops from the back
+ *   those it dominates and is pushed, then indices left of the window start i-k[i]+1 are dropped from the front, the front is the answer
+ * every index is pushed and popped at most once so it is O(n) regardless of window sizes, but it needs window starts that never
+ *   move left, as produced by frolladapt(); otherwise we fall back to exact
+ * NaN are not pushed, instead the most recent NA and NaN are tracked so that NA > NaN > any value unless narm, as in exact
+ */
+static bool frolladaptiveextremeFast(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose, bool ismax) {
+  const char *fun = ismax ? "frolladaptivemaxFast" : "frolladaptiveminFast";
+  int64_t start = 0; // window start of the previous (non-fill) observation
+  for (uint64_t i=0; i<nx; i++) {
+    if (i+1 < k[i])
+      continue;
+    const int64_t s = (int64_t)i-k[i]+1;
+    if (s < start) {
+      if (verbose)
+        snprintf(end(ans->message[0]), 500, _("%s: window start moves left at observation %"PRIu64", fall back to exact\n"), fun, (uint64_t)i+1);
+      return false;
+    }
+    start = s;
+  }
+  if (verbose)
+    snprintf(end(ans->message[0]), 500, _("%s: running for input length %"PRIu64", hasnf %d, narm %d\n"), fun, (uint64_t)nx, hasnf, (int)narm);
+  uint64_t *dq = malloc(sizeof(*dq) * (nx ? nx : 1));
+  if (!dq) {                                                        // # nocov start
+    ansSetMsg(ans, 3, "%s: Unable to allocate memory for deque", __func__); // raise error
+    return true;
+  }                                                                 // # nocov end
+  const bool skipnf = narm || hasnf==-1;
+  const double empty = ismax ? R_NegInf : R_PosInf;
+  uint64_t head=0, tail=0; // dq[head..tail) are in the deque
+  int64_t lastna=-1, lastnan=-1;
+  for (uint64_t i=0; i<nx; i++) {
+    const double xi = x[i];
+    if (ISNAN(xi)) {
+      if (ISNA(xi)) lastna = i; else lastnan = i;
+    } else {
+      if (ismax) {
+        while (tail>head && x[dq[tail-1]] <= xi) tail--;
+      } else {
+        while (tail>head && x[dq[tail-1]] >= xi) tail--;
+      }
+      dq[tail++] = i;
+    }
+    if (i+1 < k[i]) {
+      ans->dbl_v[i] = fill;
+      continue;
+    }
+    const int64_t s = (int64_t)i-k[i]+1;
+    while (tail>head && (int64_t)dq[head] < s) head++;
+    if (!skipnf && lastna >= s) {
+      ans->dbl_v[i] = NA_REAL;
+    } else if (!skipnf && lastnan >= s) {
+      ans->dbl_v[i] = R_NaN;
+    } else {
+      ans->dbl_v[i] = tail>head ? x[dq[head]] : empty; // also k[i]==0 then -Inf for max, +Inf for min
+    }
+  }
+  free(dq);
+  return true;
+}
+void frolladaptivemaxFast(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose) {
+  if (!frolladaptiveextremeFast(x, nx, ans, k, fill, narm, hasnf, verbose, /*ismax=*/true))
+    frolladaptivemaxExact(x, nx, ans, k, fill, narm, hasnf, verbose);
+}
+void frolladaptiveminFast(const double *x, uint64_t nx, ans_t *ans, const int *k, double fill, bool narm, int hasnf, bool verbose) {
+  if (!frolladaptiveextremeFast(x, nx, ans, k, fill, narm, hasnf, verbose, /*ismax=*/false))
+    frolladaptiveminExact(x, nx, ans, k, fill, narm, hasnf, verbose);
+}
+
 /* fast rolling adaptive max - exact
  * for has.nf=FALSE it will not detect if any NAs were in the input, therefore could produce incorrect result, well documented
  */
@@ -0,0 +1,455 @@
+#include "data.table.h"
+
+/*
+  Rolling sum, min, max and prod on integer (and logical) and integer64 input, rolled as it is
+    rather than on a double copy of the whole column made by coerceX() in frollR.c.
+
+  integer input gives double answer, same as it did after coercion; integer64 input gives integer64 answer.
+  Sums are accumulated exactly: in int64_t for integer, in two 64 bit words for integer64; window sum or
+    product of integer64 out of integer64 range gives NA and a warning.
+  NA is the only non-finite value here, so has.nf=FALSE only controls the warning when NAs are present;
+    min and max ignore NAs then, the same as the double versions do.
+  sum, min and max are exact whatever algo:
+    sum is a single pass sliding window, for adaptive window a difference of cumulative sums
+    min and max keep a monotonic deque of indices, for adaptive window only when window start never moves left,
+      otherwise each window is scanned
+  prod of integer uses algo: "fast" keeps a running product as frollprodFast does, "exact" scans each window;
+    prod of integer64 is exact either way, from products of blocks of k observations
+  k is the window width, or when ka is not NULL, ka is the adaptive window width of each observation.
+  par is false when the caller is already parallel, over columns and windows or over groups, so as not to nest.
+*/
+
+#undef WIDTH
+#define WIDTH(i) (ka ? ka[i] : k)
+
+// signed 128 bit integer as two 64 bit words, for exact window sums of integer64
+typedef struct i128_t {
+  uint64_t lo;
+  int64_t hi;
+} i128_t;
+static inline void i128add(i128_t *a, int64_t v) {
+  const uint64_t lo = a->lo + (uint64_t)v;
+  a->hi += (v<0 ? -1 : 0) + (lo < a->lo);
+  a->lo = lo;
+}
+static inline i128_t i128sub(i128_t a, i128_t b) {
+  return (i128_t) { .lo=a.lo-b.lo, .hi=a.hi-b.hi-(a.lo < b.lo) };
+}
+static inline bool i128fits(i128_t a) { // INT64_MIN is NA_INTEGER64 so it does not fit
+  return (a.hi==0 && a.lo<=INT64_MAX) || (a.hi==-1 && a.lo>(uint64_t)INT64_MIN);
+}
+static inline bool i64mulovf(int64_t a, int64_t b) { // neither a nor b is NA_INTEGER64
+  if (a==0 || b==0)
+    return false;
+  const uint64_t ua = a<0 ? -(uint64_t)a : (uint64_t)a, ub = b<0 ? -(uint64_t)b : (uint64_t)b;
+  return ua > (uint64_t)INT64_MAX / ub;
+}
+
+static void frollsumInt(const int *x, uint64_t nx, ans_t *ans, int k, const int *ka, double fill, bool narm, int hasnf, bool verbose, bool par) {
+  if (verbose)
+    snprintf(end(ans->message[0]), 500, _("%s: running for input length %"PRIu64", hasnf %d, narm %d\n"), __func__, nx, hasnf, (int)narm);
+  double *o = ans->dbl_v;
+  bool anyna = false;
+  if (!ka) {
+    int64_t w = 0;
+    int nc = 0;
+    for (uint64_t i=0; i<nx; i++) {
+      if (x[i]==NA_INTEGER) {
+        nc++; anyna = true;
+      } else {
+        w += x[i];
+      }
+      if (i >= k) { // observation leaving the window, for k==0 the one just added
+        if (x[i-k]==NA_INTEGER) nc--; else w -= x[i-k];
+      }
+      o[i] = i+1 < k ? fill : (nc && !narm) ? NA_REAL : (double)w;
+    }
+  } else {
+    int64_t *cs = malloc(sizeof(*cs) * (nx+1));
+    uint64_t *cn = malloc(sizeof(*cn) * (nx+1));
+    if (!cs || !cn) {                                                   // # nocov start
+      free(cs); free(cn);
+      ansSetMsg(ans, 3, "%s: Unable to allocate memory for cumulative sum", __func__); // raise error
+      return;
+    }                                                                   // # nocov end
+    cs[0] = 0; cn[0] = 0;
+    for (uint64_t i=0; i<nx; i++) {
+      const bool na = x[i]==NA_INTEGER;
+      cs[i+1] = cs[i] + (na ? 0 : x[i]);
+      cn[i+1] = cn[i] + na;
+    }
+    anyna = cn[nx] > 0;
+    #pragma omp parallel for if (par) num_threads(getDTthreads(nx, true))
+    for (uint64_t i=0; i<nx; i++) {
+      const int w = ka[i];
+      o[i] = i+1 < w ? fill : (cn[i+1]!=cn[i+1-w] && !narm) ? NA_REAL : (double)(cs[i+1]-cs[i+1-w]);
+    }
+    free(cs); free(cn);
+  }
+  if (anyna && hasnf==-1)
+    ansSetMsg(ans, 2, "%s: has.nf=FALSE used but non-finite values are present in input, use default has.nf=NA to avoid this warning", __func__);
+}
+
+static void frollsumInt64(const int64_t *x, uint64_t nx, ans_t *ans, int k, const int *ka, int64_t fill, bool narm, int hasnf, bool verbose, bool par) {
+  if (verbose)
+    snprintf(end(ans->message[0]), 500, _("%s: running for input length %"PRIu64", hasnf %d, narm %d\n"), __func__, nx, hasnf, (int)narm);
+  int64_t *o = ans->int64_v;
+  bool anyna = false, ovf = false;
+  if (!ka) {
+    i128_t w = { 0, 0 };
+    int nc = 0;
+    for (uint64_t i=0; i<nx; i++) {
+      if (x[i]==NA_INTEGER64) {
+        nc++; anyna = true;
+      } else {
+        i128add(&w, x[i]);
+      }
+      if (i >= k) {
+        if (x[i-k]==NA_INTEGER64) nc--; else i128add(&w, -x[i-k]);
+      }
+      if (i+1 < k) {
+        o[i] = fill;
+      } else if (nc && !narm) {
+        o[i] = NA_INTEGER64;
+      } else if (!i128fits(w)) {
+        o[i] = NA_INTEGER64; ovf = true;
+      } else {
+        o[i] = (int64_t)w.lo;
+      }
+    }
+  } else {
+    i128_t *cs = malloc(sizeof(*cs) * (nx+1));
+    uint64_t *cn = malloc(sizeof(*cn) * (nx+1));
+    if (!cs || !cn) {                                                   // # nocov start
+      free(cs); free(cn);
+      ansSetMsg(ans, 3, "%s: Unable to allocate memory for cumulative sum", __func__); // raise error
+      return;
+    }                                                                   // # nocov end
+    cs[0] = (i128_t) { 0, 0 }; cn[0] = 0;
+    for (uint64_t i=0; i<nx; i++) {
+      const bool na = x[i]==NA_INTEGER64;
+      cs[i+1] = cs[i];
+      if (!na) i128add(&cs[i+1], x[i]);
+      cn[i+1] = cn[i] + na;
+    }
+    anyna = cn[nx] > 0;
+    #pragma omp parallel for if (par) num_threads(getDTthreads(nx, true))
+    for (uint64_t i=0; i<nx; i++) {
+      const int w = ka[i];
+      if (i+1 < w) {
+        o[i] = fill;
+      } else if (cn[i+1]!=cn[i+1-w] && !narm) {
+        o[i] = NA_INTEGER64;
+      } else {
+        const i128_t s = i128sub(cs[i+1], cs[i+1-w]);
+        if (i128fits(s)) {
+          o[i] = (int64_t)s.lo;
+        } else {
+          o[i] = NA_INTEGER64;
+          #pragma omp atomic write
+          ovf = true;
+        }
+      }
+    }
+    free(cs); free(cn);
+  }
+  if (anyna && hasnf==-1)
+    ansSetMsg(ans, 2, "%s: has.nf=FALSE used but non-finite values are present in input, use default has.nf=NA to avoid this warning", __func__);
+  if (ovf)
+    ansSetMsg(ans, 2, "%s: sum of a window is out of integer64 range, NA is returned for such windows", __func__);
+}
+
+/* rolling min and max - template for integer and integer64
+ * deque holds indices of observations in the window whose values are strictly decreasing (max) or increasing (min) from the head
+ * each observation is pushed and popped once, so it is linear whatever the window width
+ * its capacity is the largest window + 1 so it is kept as a ring buffer
+ */
+#undef FROLLEXTREME
+#define FROLLEXTREME(NAME, CTYPE, NAVAL, OTYPE, OVEC, ONA, OEMPTYMAX, OEMPTYMIN)                   \
+static void NAME(const CTYPE *x, uint64_t nx, ans_t *ans, int k, const int *ka, OTYPE fill, bool narm, int hasnf, bool verbose, bool par, bool ismax) { \
+  OTYPE *o = ans->OVEC;                                                                           \
+  const bool skipna = narm || hasnf==-1;                                                          \
+  const OTYPE empty = ismax ? OEMPTYMAX : OEMPTYMIN;                                              \
+  bool deque = true;                                                                              \
+  uint64_t cap = k;                                                                               \
+  if (ka) {                                                                                       \
+    int64_t start = 0;                                                                            \
+    cap = 0;                                                                                      \
+    for (uint64_t i=0; i<nx && deque; i++) {                                                      \
+      if (ka[i] > cap) cap = ka[i];                                                               \
+      if (i+1 < ka[i])                                                                            \
+        continue;                                                                                 \
+      const int64_t s = (int64_t)i-ka[i]+1;                                                       \
+      deque = s >= start;                                                                         \
+      start = s;                                                                                  \
+    }                                                                                             \
+  }                                                                                               \
+  if (verbose)                                                                                    \
+    snprintf(end(ans->message[0]), 500, _("%s: running %s for input length %"PRIu64", hasnf %d, narm %d\n"), #NAME, deque ? "monotonic deque" : "scan of each window because window start moves left", nx, hasnf, (int)narm); \
+  if (deque) {                                                                                    \
+    cap = (cap < nx ? cap : nx) + 1;                                                              \
+    uint64_t *dq = malloc(sizeof(*dq) * cap);                                                     \
+    if (!dq) {                                                      /* # nocov start */           \
+      ansSetMsg(ans, 3, "%s: Unable to allocate memory for deque", #NAME); /* raise error */      \
+      return;                                                                                     \
+    }                                                               /* # nocov end */             \
+    uint64_t head=0, len=0;                                                                       \
+    int64_t lastna=-1;                                                                            \
+    for (uint64_t i=0; i<nx; i++) {                                                               \
+      const CTYPE xi = x[i];                                                                      \
+      if (xi==NAVAL) {                                                                            \
+        lastna = i;                                                                               \
+      } else {                                                                                    \
+        if (ismax) {                                                                              \
+          while (len && x[dq[(head+len-1)%cap]] <= xi) len--;                                     \
+        } else {                                                                                  \
+          while (len && x[dq[(head+len-1)%cap]] >= xi) len--;                                     \
+        }                                                                                         \
+        dq[(head+len++)%cap] = i;                                                                 \
+      }                                                                                           \
+      const int w = WIDTH(i);                                                                     \
+      if (i+1 < w) {                                                                              \
+        o[i] = fill;                                                                              \
+        continue;                                                                                 \
+      }                                                                                           \
+      const int64_t s = (int64_t)i-w+1;                                                           \
+      while (len && (int64_t)dq[head] < s) {                                                      \
+        head = (head+1)%cap; len--;                                                               \
+      }                                                                                           \
+      o[i] = (!skipna && lastna >= s) ? ONA : len ? (OTYPE)x[dq[head]] : empty;                   \
+    }                                                                                             \
+    free(dq);                                                                                     \
+  } else {                                                                                        \
+    _Pragma("omp parallel for if (par) num_threads(getDTthreads(nx, true))")                      \
+    for (uint64_t i=0; i<nx; i++) {                                                               \
+      const int w = ka[i];                                                                        \
+      if (i+1 < w) {                                                                              \
+        o[i] = fill;                                                                              \
+        continue;                                                                                 \
+      }                                                                                           \
+      CTYPE v = 0;                                                                                \
+      bool found = false, na = false;                                                             \
+      for (uint64_t j=i+1-w; j<=i; j++) {                                                         \
+        if (x[j]==NAVAL) {                                                                        \
+          na = true;                                                                              \
+          if (!skipna) break;                                                                     \
+        } else if (!found || (ismax ? x[j]>v : x[j]<v)) {                                         \
+          v = x[j]; found = true;                                                                 \
+        }                                                                                         \
+      }                                                                                           \
+      o[i] = (na && !skipna) ? ONA : found ? (OTYPE)v : empty;                                    \
+    }                                                                                             \
+  }                                                                                               \
+}
+FROLLEXTREME(frollextremeInt, int, NA_INTEGER, double, dbl_v, NA_REAL, R_NegInf, R_PosInf)
+// no -Inf and Inf in integer64, so max and min of an empty window (or of NAs only with na.rm=TRUE) are NA
+FROLLEXTREME(frollextremeInt64, int64_t, NA_INTEGER64, int64_t, int64_v, NA_INTEGER64, NA_INTEGER64, NA_INTEGER64)
+
+/* rolling prod of integer
+ * algo="fast" with a fixed window keeps a running product of the non-zero non-NA values of the window, and counts of
+ *   zeros and NAs, as frollprodFast does; should that product overflow long double each window is scanned instead
+ * algo="exact" and adaptive window scan each window, in parallel
+ */
+static void frollprodInt(const int *x, uint64_t nx, ans_t *ans, int k, const int *ka, double fill, bool narm, int hasnf, bool verbose, unsigned int algo, bool par) {
+  double *o = ans->dbl_v;
+  bool anyna = false, scan = ka || algo==1 || k==0;
+  if (!scan) {
+    long double w = 1.0;
+    int nna = 0, nzero = 0;
+    for (uint64_t i=0; i<nx; i++) {
+      if (i >= k) { // observation leaving the window
+        if (x[i-k]==NA_INTEGER) nna--; else if (x[i-k]==0) nzero--; else w /= x[i-k];
+      }
+      if (x[i]==NA_INTEGER) {
+        nna++; anyna = true;
+      } else if (x[i]==0) {
+        nzero++;
+      } else {
+        w *= x[i];
+      }
+      if (!isfinite(w)) { // it cannot be divided back
+        scan = true; anyna = false;
+        break;
+      }
+      o[i] = i+1 < k ? fill : (nna && !narm) ? NA_REAL : nzero ? 0.0 : (double)w;
+    }
+  }
+  if (verbose)
+    snprintf(end(ans->message[0]), 500, _("%s: running %s for input length %"PRIu64", hasnf %d, narm %d\n"), __func__, scan ? "scan of each window" : "sliding product", nx, hasnf, (int)narm);
+  if (scan) {
+    #pragma omp parallel for if (par) num_threads(getDTthreads(nx, true))
+    for (uint64_t i=0; i<nx; i++) {
+      const int w = WIDTH(i);
+      if (i+1 < w) {
+        o[i] = fill;
+        continue;
+      }
+      long double p = 1.0;
+      bool na = false, zero = false;                              // zero kept aside as long double can overflow to Inf for very wide windows
+      for (uint64_t j=i+1-w; j<=i; j++) {
+        if (x[j]==NA_INTEGER) {
+          na = true;
+          if (!narm) break;
+        } else if (x[j]==0) {
+          zero = true;
+        } else {
+          p *= x[j];
+        }
+      }
+      if (na) {
+        #pragma omp atomic write
+        anyna = true;
+      }
+      o[i] = (na && !narm) ? NA_REAL : zero ? 0.0 : (double)p;
+    }
+  }
+  if (anyna && hasnf==-1)
+    ansSetMsg(ans, 2, "%s: has.nf=FALSE used but non-finite values are present in input, use default has.nf=NA to avoid this warning", __func__);
+}
+
+// product of a and b, NA_INTEGER64 standing for a product out of range; no product in range is INT64_MIN, see i64mulovf
+static inline int64_t i64prod(int64_t a, int64_t b) {
+  return (a==NA_INTEGER64 || b==NA_INTEGER64 || i64mulovf(a, b)) ? NA_INTEGER64 : a*b;
+}
+
+/* rolling prod of integer64
+ * fixed window: a running product cannot be divided back once it overflows, so x is cut into blocks of k observations
+ *   and the product of the non-zero non-NA values of each block is kept from its start (pre) and to its end (suf); a
+ *   window starts in one block and ends in the next, so its product is suf of its start times pre of its end
+ * adaptive window scans each window, in parallel
+ */
+static void frollprodInt64(const int64_t *x, uint64_t nx, ans_t *ans, int k, const int *ka, int64_t fill, bool narm, int hasnf, bool verbose, bool par) {
+  if (verbose)
+    snprintf(end(ans->message[0]), 500, _("%s: running %s for input length %"PRIu64", hasnf %d, narm %d\n"), __func__, ka ? "scan of each window" : "block products", nx, hasnf, (int)narm);
+  int64_t *o = ans->int64_v;
+  bool anyna = false, anyovf = false;
+  if (!ka && k) {
+    int64_t *pre = malloc(sizeof(*pre) * nx), *suf = malloc(sizeof(*suf) * nx);
+    if (!pre || !suf) {                                                 // # nocov start
+      free(pre); free(suf);
+      ansSetMsg(ans, 3, "%s: Unable to allocate memory for block products", __func__); // raise error
+      return;
+    }                                                                   // # nocov end
+    #define I64PRODV(v) (((v)==NA_INTEGER64 || (v)==0) ? 1 : (v))      // zeros and NAs are counted aside
+    for (uint64_t i=0; i<nx; i++) {
+      pre[i] = i%k ? i64prod(pre[i-1], I64PRODV(x[i])) : I64PRODV(x[i]);
+    }
+    for (uint64_t i=nx; i-- > 0;) {
+      suf[i] = (i+1)%k && i+1<nx ? i64prod(suf[i+1], I64PRODV(x[i])) : I64PRODV(x[i]);
+    }
+    #undef I64PRODV
+    int nna = 0, nzero = 0;
+    for (uint64_t i=0; i<nx; i++) {
+      if (x[i]==NA_INTEGER64) {
+        nna++; anyna = true;
+      } else if (x[i]==0) {
+        nzero++;
+      }
+      if (i >= k) { // observation leaving the window
+        if (x[i-k]==NA_INTEGER64) nna--; else if (x[i-k]==0) nzero--;
+      }
+      if (i+1 < k) {
+        o[i] = fill;
+        continue;
+      }
+      const uint64_t s = i+1-k;
+      const int64_t p = s%k ? i64prod(suf[s], pre[i]) : pre[i];
+      if (nna && !narm) {
+        o[i] = NA_INTEGER64;
+      } else if (nzero) {
+        o[i] = 0;
+      } else {
+        o[i] = p;
+        if (p==NA_INTEGER64) anyovf = true;
+      }
+    }
+    free(pre); free(suf);
+  } else {
+    #pragma omp parallel for if (par) num_threads(getDTthreads(nx, true))
+    for (uint64_t i=0; i<nx; i++) {
+      const int w = WIDTH(i);
+      if (i+1 < w) {
+        o[i] = fill;
+        continue;
+      }
+      int64_t p = 1;
+      bool na = false, zero = false, ovf = false;                 // after overflow keep scanning, a later 0 or NA still decides the answer
+      for (uint64_t j=i+1-w; j<=i; j++) {
+        if (x[j]==NA_INTEGER64) {
+          na = true;
+          if (!narm) break;
+        } else if (x[j]==0) {
+          zero = true;
+        } else if (!ovf) {
+          if (i64mulovf(p, x[j])) ovf = true; else p *= x[j];
+        }
+      }
+      if (na) {
+        #pragma omp atomic write
+        anyna = true;
+      }
+      if (na && !narm) {
+        o[i] = NA_INTEGER64;
+      } else if (zero) {
+        o[i] = 0;
+      } else if (ovf) {
+        o[i] = NA_INTEGER64;
+        #pragma omp atomic write
+        anyovf = true;
+      } else {
+        o[i] = p;
+      }
+    }
+  }
+  if (anyna && hasnf==-1)
+    ansSetMsg(ans, 2, "%s: has.nf=FALSE used but non-finite values are present in input, use default has.nf=NA to avoid this warning", __func__);
+  if (anyovf)
+    ansSetMsg(ans, 2, "%s: product of a window is out of integer64 range, NA is returned for such windows", __func__);
+}
+
+/* rolling fun on integer or integer64 - router for fun, handles align like frollfun does
+ * only SUM, MIN, MAX and PROD, other funs roll on double, see frollfunR
+ * answer goes to ans->dbl_v for integer and to ans->int64_v for integer64, fill is dfill or i64fill accordingly
+ * par tells if it can use openmp, false when the caller is parallel already
+ */
+void frollfunInt(rollfun_t rfun, unsigned int algo, const void *x, bool int64, uint64_t nx, ans_t *ans, int k, const int *ka, int align, double dfill, int64_t i64fill, bool narm, int hasnf, bool verbose, bool par) {
+  double tic = 0;
+  if (verbose)
+    tic = omp_get_wtime();
+  if (!ka && nx < k) {
+    if (verbose)
+      snprintf(end(ans->message[0]), 500, _("%s: window width longer than input vector, returning all NA vector\n"), __func__);
+    for (uint64_t i=0; i<nx; i++) {
+      if (int64) ans->int64_v[i] = i64fill; else ans->dbl_v[i] = dfill;
+    }
+    return;
+  }
+  switch (rfun) {
+  case SUM :
+    if (int64) frollsumInt64(x, nx, ans, k, ka, i64fill, narm, hasnf, verbose, par);
+    else frollsumInt(x, nx, ans, k, ka, dfill, narm, hasnf, verbose, par);
+    break;
+  case MAX : case MIN :
+    if (int64) frollextremeInt64(x, nx, ans, k, ka, i64fill, narm, hasnf, verbose, par, rfun==MAX);
+    else frollextremeInt(x, nx, ans, k, ka, dfill, narm, hasnf, verbose, par, rfun==MAX);
+    break;
+  case PROD :
+    if (int64) frollprodInt64(x, nx, ans, k, ka, i64fill, narm, hasnf, verbose, par);
+    else frollprodInt(x, nx, ans, k, ka, dfill, narm, hasnf, verbose, algo, par);
+    break;
+  default: // # nocov
+    internal_error(__func__, "rfun %d has no integer implementation, should have been rolled on double", rfun); // # nocov
+  }
+  if (!ka && k && align < 1 && ans->status < 3) {
+    int k_ = align==-1 ? k-1 : floor(k/2);       // offset to shift
+    if (verbose)
+      snprintf(end(ans->message[0]), 500, _("%s: align %d, shift answer by %d\n"), __func__, align, -k_);
+    // dbl_v and int64_v are both 8 bytes and point to the same answer vector
+    memmove((char *)ans->dbl_v, (char *)ans->dbl_v + (k_*sizeof(double)), (nx-k_)*sizeof(double));
+    for (uint64_t i=nx-k_; i<nx; i++) {
+      if (int64) ans->int64_v[i] = i64fill; else ans->dbl_v[i] = dfill;
+    }
+  }
+  if (verbose)
+    snprintf(end(ans->message[0]), 500, _("%s: processing fun %d took %.3fs\n"), __func__, rfun, omp_get_wtime()-tic);
+}
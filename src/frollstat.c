@@ -0,0 +1,518 @@
+#include "data.table.h"
+
+/* rolling quantile, rank, uniqueN, skewness and kurtosis
+ * quantile, rank and uniqueN algo="fast" rank the values of x once, and keep counts of the ranks in the window in a
+ *   Fenwick tree; adding or removing an observation and finding the j-th smallest or the number of smaller values in
+ *   the window are then O(log(u)) for u distinct values of x, rather than O(n) of finding them in each window
+ * skew and kurt algo="fast" keep the power sums of the window, centred at the mean of the window every n observations
+ *   so they do not lose precision to a drifting mean, with compensated summation
+ * algo="exact" computes each window from scratch, in parallel over windows
+ * all of them roll windows aligned right, frollfun shifts the answer for align left and center
+ */
+
+// Fenwick tree of counts of value ranks in the window, and of NA and NaN which have no rank
+typedef struct {
+  int *bit;      // bit[1..nu]
+  int *cnt;      // count of each rank in the window
+  int nu, top;   // number of distinct values, highest power of 2 not above nu
+  int n, ndistinct, nna, nnan;
+} owin_t;
+
+#define RANK_NA -1
+#define RANK_NAN -2
+
+static inline void owadd(owin_t *w, int r, int d) {
+  if (r < 0) {
+    if (r==RANK_NA) w->nna += d; else w->nnan += d;
+    return;
+  }
+  w->n += d;
+  if (d > 0) {
+    if (w->cnt[r]++ == 0) w->ndistinct++;
+  } else {
+    if (--w->cnt[r] == 0) w->ndistinct--;
+  }
+  for (int i=r+1; i<=w->nu; i+=i&-i) w->bit[i] += d;
+}
+// number of values in the window smaller than rank r
+static inline int owless(const owin_t *w, int r) {
+  int s = 0;
+  for (int i=r; i>0; i-=i&-i) s += w->bit[i];
+  return s;
+}
+// rank of j-th (1-based) smallest value in the window
+static inline int owkth(const owin_t *w, int j) {
+  int pos = 0;
+  for (int step=w->top; step; step>>=1) {
+    if (pos+step <= w->nu && w->bit[pos+step] < j) {
+      pos += step;
+      j -= w->bit[pos];
+    }
+  }
+  return pos;
+}
+
+static int dcmp(const void *a, const void *b) {
+  const double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/* rank of each value of x among the distinct values of x, u are the distinct values in increasing order
+ * RANK_NA and RANK_NAN for NA and NaN
+ */
+static void rankx(const double *x, uint64_t nx, int *rk, double *u, int *nu, bool par) {
+  int m = 0;
+  for (uint64_t i=0; i<nx; i++) {
+    if (!ISNAN(x[i]))
+      u[m++] = x[i];
+  }
+  qsort(u, m, sizeof(*u), dcmp);
+  int d = 0;
+  for (int i=0; i<m; i++) {
+    if (!d || u[i]!=u[d-1])
+      u[d++] = u[i];
+  }
+  *nu = d;
+  #pragma omp parallel for if (par) num_threads(getDTthreads(nx, true))
+  for (uint64_t i=0; i<nx; i++) {
+    if (ISNAN(x[i])) {
+      rk[i] = ISNA(x[i]) ? RANK_NA : RANK_NAN;
+      continue;
+    }
+    int lo = 0, hi = d-1; // x[i] is in u
+    while (lo < hi) {
+      int mid = lo + (hi-lo)/2;
+      if (u[mid] < x[i]) lo = mid+1; else hi = mid;
+    }
+    rk[i] = lo;
+  }
+}
+
+// type 7 quantile, the default of stats::quantile, as gquantile7 in gsumm.c
+static inline double owquantile(const owin_t *w, const double *u, double p) {
+  if (!w->n)
+    return NA_REAL;
+  const double index = 1 + (w->n-1)*p;
+  const int lo = (int)floor(index), hi = (int)ceil(index);
+  double qs = u[owkth(w, lo)];
+  if (index > lo) {
+    const double xhi = u[owkth(w, hi)];
+    if (xhi != qs) {
+      const double h = index - lo;
+      qs = (1 - h) * qs + h * xhi;
+    }
+  }
+  return qs;
+}
+
+// statistic of the window in w, c is the observation being ranked for rank
+static inline double owvalue(rollfun_t rfun, const owin_t *w, const double *u, const int *rk, uint64_t c, double p, bool narm) {
+  const bool anyna = w->nna || w->nnan;
+  switch (rfun) {
+  case QUANTILE :
+    return !narm && anyna ? NA_REAL : owquantile(w, u, p);
+  case RANK :
+    if (rk[c] < 0 || (!narm && anyna))
+      return NA_REAL;
+    return owless(w, rk[c]) + (w->cnt[rk[c]]+1)/2.0; // ties get their average rank
+  case UNIQUEN :
+    return w->ndistinct + (narm ? 0 : (w->nna>0) + (w->nnan>0)); // NA and NaN are distinct values as in uniqueN
+  default: // # nocov
+    return NA_REAL; // # nocov
+  }
+}
+
+static const char *statname(rollfun_t rfun) {
+  switch (rfun) {
+  case QUANTILE : return "quantile";
+  case SKEW : return "skew";
+  case KURT : return "kurt";
+  case RANK : return "rank";
+  case UNIQUEN : return "uniqueN";
+  default : return "unknown"; // # nocov
+  }
+}
+
+/* quantile, rank and uniqueN - fast
+ * ka NULL: window k of every observation, the series is split into chunks, one per thread when par, each thread with
+ *   its own Fenwick tree starting from the window preceding its chunk. With more than one chunk the values of each chunk
+ *   are ranked again among those in its windows only, so the trees together are the size of x rather than of nth*u
+ * ka not NULL: adaptive window of each observation; the window end only moves forward and its start is moved to where
+ *   it has to be, so it is linear in nx when the window start never moves left, as for frolladapt and partial=TRUE
+ * off is the position within the window of the observation ranked by rank, so rank of align left ranks its first one
+ */
+static int icmp(const void *a, const void *b) {
+  const int x = *(const int *)a, y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+/* ranks lr of the observations [from, to) among the distinct values lu of that range only, from their ranks rk among
+ * all the distinct values u; tmp is scratch of to-from ints
+ */
+static void rankrange(const int *rk, const double *u, uint64_t from, uint64_t to, int *lr, double *lu, int *lnu, int *tmp) {
+  int m = 0;
+  for (uint64_t i=from; i<to; i++) {
+    if (rk[i] >= 0)
+      tmp[m++] = rk[i];
+  }
+  qsort(tmp, m, sizeof(*tmp), icmp);
+  int d = 0;
+  for (int i=0; i<m; i++) {
+    if (!d || tmp[i]!=tmp[d-1])
+      tmp[d++] = tmp[i];
+  }
+  for (int j=0; j<d; j++) lu[j] = u[tmp[j]];
+  *lnu = d;
+  for (uint64_t i=from; i<to; i++) {
+    if (rk[i] < 0) {
+      lr[i-from] = rk[i];
+      continue;
+    }
+    int lo = 0, hi = d-1; // rk[i] is in tmp
+    while (lo < hi) {
+      int mid = lo + (hi-lo)/2;
+      if (tmp[mid] < rk[i]) lo = mid+1; else hi = mid;
+    }
+    lr[i-from] = lo;
+  }
+}
+
+/* rolls the windows of k ending at each of [from, to) into ansv; x[i] has rank rk[i-base] among the nu values u
+ * false when the Fenwick tree could not be allocated
+ */
+static bool owroll(rollfun_t rfun, const int *rk, uint64_t base, const double *u, int nu, uint64_t from, uint64_t to, int k, int off, double p, bool narm, double *ansv) {
+  int *bit = calloc(2*(size_t)nu+1, sizeof(*bit));
+  if (!bit)
+    return false; // # nocov
+  int top = 1;
+  while (top*2 <= nu) top *= 2;
+  owin_t w = { .bit=bit, .cnt=bit+nu+1, .nu=nu, .top=top, .n=0, .ndistinct=0, .nna=0, .nnan=0 };
+  for (uint64_t i=from+1-k; i<from; i++) {
+    owadd(&w, rk[i-base], 1);
+  }
+  for (uint64_t i=from; i<to; i++) {
+    owadd(&w, rk[i-base], 1);
+    ansv[i] = owvalue(rfun, &w, u, rk, i+1-k+off-base, p, narm);
+    owadd(&w, rk[i+1-k-base], -1);
+  }
+  free(bit);
+  return true;
+}
+
+static void frollorderFast(rollfun_t rfun, const double *x, uint64_t nx, ans_t *ans, int k, const int *ka, int off, double p, double fill, bool narm, int hasnf, bool verbose, bool par) {
+  const char *fun = statname(rfun);
+  if (verbose)
+    snprintf(end(ans->message[0]), 500, _("%s: running %s for input length %"PRIu64", window %d, hasnf %d, narm %d\n"), "frollorderFast", fun, (uint64_t)nx, ka ? -1 : k, hasnf, (int)narm);
+  if (!ka && k == 0) { // quantile and rank of no values is NA, they have no distinct values
+    if (verbose)
+      snprintf(end(ans->message[0]), 500, _("%s: window width of size 0, returning all %s vector\n"), __func__, rfun==UNIQUEN ? "0" : "NA");
+    for (uint64_t i=0; i<nx; i++) {
+      ans->dbl_v[i] = rfun==UNIQUEN ? 0.0 : NA_REAL;
+    }
+    return;
+  }
+  int *rk = malloc(sizeof(*rk) * nx);
+  double *u = malloc(sizeof(*u) * nx);
+  if (!rk || !u) { // # nocov start
+    ansSetMsg(ans, 3, "%s: Unable to allocate memory for ranks", __func__); // raise error
+    free(rk); free(u);
+    return;
+  } // # nocov end
+  int nu = 0;
+  rankx(x, nx, rk, u, &nu, par);
+  if (hasnf==-1) {
+    for (uint64_t i=0; i<nx; i++) {
+      if (rk[i] < 0) {
+        ansSetMsg(ans, 2, "%s: has.nf=FALSE used but non-finite values are present in input, use default has.nf=NA to avoid this warning", __func__);
+        break;
+      }
+    }
+  }
+  if (!ka) {
+    for (int i=0; i<k-1; i++) {
+      ans->dbl_v[i] = fill;
+    }
+    const uint64_t nw = nx-k+1;                                 // number of windows
+    int nth = par ? getDTthreads(nw, true) : 1;
+    if (nth > nw/k) nth = nw/k ? nw/k : 1;                      // each chunk first fills its window, so it has to be longer than one window
+    if (verbose)
+      snprintf(end(ans->message[0]), 500, _("%s: %d distinct values, rolling %d chunk(s) of windows\n"), __func__, nu, nth);
+    const uint64_t chunk = (nw + nth - 1) / nth;
+    bool failed = false;
+    #pragma omp parallel for num_threads(nth)
+    for (int c=0; c<nth; c++) {
+      const uint64_t from = k-1 + c*chunk, to = MIN(from+chunk, nx), base = from+1-k;
+      if (from >= to)
+        continue;
+      if (nth == 1) {
+        if (!owroll(rfun, rk, 0, u, nu, from, to, k, off, p, narm, ans->dbl_v)) failed = true;
+        continue;
+      }
+      int *lr = malloc(sizeof(*lr) * (to-base)), *tmp = malloc(sizeof(*tmp) * (to-base)), lnu = 0;
+      double *lu = malloc(sizeof(*lu) * (to-base));
+      bool ok = lr && tmp && lu;
+      if (ok) {
+        rankrange(rk, u, base, to, lr, lu, &lnu, tmp);
+        free(tmp); tmp = NULL;
+        ok = owroll(rfun, lr, base, lu, lnu, from, to, k, off, p, narm, ans->dbl_v);
+      }
+      free(lr); free(tmp); free(lu);
+      if (!ok) failed = true; // # nocov
+    }
+    if (failed) { // # nocov start
+      ansSetMsg(ans, 3, "%s: Unable to allocate memory for Fenwick tree", __func__); // raise error
+      free(rk); free(u);
+      return;
+    } // # nocov end
+  } else {
+    int top = 1;
+    while (top*2 <= nu) top *= 2;
+    int *bit = calloc(2*nu+1, sizeof(*bit));
+    if (!bit) { // # nocov start
+      ansSetMsg(ans, 3, "%s: Unable to allocate memory for Fenwick tree", __func__); // raise error
+      free(rk); free(u);
+      return;
+    } // # nocov end
+    owin_t w = { .bit=bit, .cnt=bit+nu+1, .nu=nu, .top=top, .n=0, .ndistinct=0, .nna=0, .nnan=0 };
+    uint64_t s = 0, moved = 0;                                  // window is x[s..i]
+    for (uint64_t i=0; i<nx; i++) {
+      owadd(&w, rk[i], 1);
+      if (i+1 < ka[i]) {
+        ans->dbl_v[i] = fill;
+        continue;
+      }
+      const uint64_t news = i+1-ka[i];
+      for (; s < news; s++) owadd(&w, rk[s], -1);
+      for (; s > news; moved++) owadd(&w, rk[--s], 1);
+      if (!ka[i]) {
+        ans->dbl_v[i] = rfun==UNIQUEN ? 0.0 : NA_REAL;
+        continue;
+      }
+      ans->dbl_v[i] = owvalue(rfun, &w, u, rk, i, p, narm);
+    }
+    if (verbose && moved)
+      snprintf(end(ans->message[0]), 500, _("%s: window start moved left by %"PRIu64" observations in total\n"), __func__, moved);
+    free(bit);
+  }
+  free(rk); free(u);
+}
+
+/* sample skewness and excess kurtosis, adjusted Fisher-Pearson G1 and G2, from the central moments m2, m3, m4 of n values
+ * NaN for a window of constant values
+ */
+static inline double momentstat(bool kurt, long double n, long double m2, long double m3, long double m4) {
+  if (!(m2 > 0))
+    return R_NaN;
+  if (!kurt)
+    return (double) (sqrtl(n*(n-1))/(n-2) * m3/powl(m2, 1.5L));
+  long double g2 = m4/(m2*m2) - 3;
+  return (double) (((n+1)*g2 + 6) * (n-1)/((n-2)*(n-3)));
+}
+
+// Neumaier compensated summation
+static inline void ksum(long double *s, long double *c, long double v) {
+  long double t = *s + v;
+  if (fabsl(*s) >= fabsl(v))
+    *c += (*s - t) + v;
+  else
+    *c += (v - t) + *s;
+  *s = t;
+}
+
+/* skew and kurt - fast
+ * power sums S[1..4] of x-centre over the window, rebased every k observations at the mean of the window,
+ *   so it is still linear as the rebase is a pass over k observations once per k observations
+ * no support for NFs, redirecting to exact
+ */
+static void frollmomentFast(bool kurt, const double *x, uint64_t nx, ans_t *ans, int k, double fill, bool narm, int hasnf, bool verbose) {
+  const char *fun = kurt ? "frollkurtFast" : "frollskewFast";
+  if (verbose)
+    snprintf(end(ans->message[0]), 500, _("%s: running for input length %"PRIu64", window %d, hasnf %d, narm %d\n"), fun, (uint64_t)nx, k, hasnf, (int)narm);
+  const int minn = kurt ? 4 : 3;
+  if (k < minn) { // skewness of less than 3, and kurtosis of less than 4 values is NA
+    if (verbose)
+      snprintf(end(ans->message[0]), 500, _("%s: window width of size %d, returning all NA vector\n"), fun, k);
+    for (uint64_t i=0; i<nx; i++) {
+      ans->dbl_v[i] = NA_REAL;
+    }
+    return;
+  }
+  bool truehasnf = hasnf>0;
+  if (!truehasnf) {
+    for (uint64_t i=0; i<nx; i++) {
+      if (!R_FINITE(x[i])) {
+        if (hasnf==-1)
+          ansSetMsg(ans, 2, "%s: has.nf=FALSE used but non-finite values are present in input, use default has.nf=NA to avoid this warning", fun);
+        truehasnf = true;
+        break;
+      }
+    }
+  }
+  if (truehasnf) {
+    if (verbose)
+      snprintf(end(ans->message[0]), 500, _("%s: non-finite values are present in input, redirecting to %s using has.nf=TRUE\n"), fun, kurt ? "frollkurtExact" : "frollskewExact");
+    frollstatExact(kurt ? KURT : SKEW, x, nx, ans, k, NULL, 0, 0, fill, narm, /*hasnf=*/true, verbose);
+    return;
+  }
+  for (int i=0; i<k-1; i++) {
+    ans->dbl_v[i] = fill;
+  }
+  const long double n = k;
+  long double S[5], C[5], centre = 0;
+  for (uint64_t i=k-1; i<nx; i++) {
+    if ((i-k+1) % k == 0) {
+      long double wsum = 0;
+      for (uint64_t j=i+1-k; j<=i; j++) wsum += x[j];
+      centre = wsum/n;
+      for (int q=1; q<5; q++) S[q] = C[q] = 0;
+      for (uint64_t j=i+1-k; j<=i; j++) {
+        long double d = x[j]-centre, dq = d;
+        for (int q=1; q<5; q++, dq*=d) ksum(&S[q], &C[q], dq);
+      }
+    } else {
+      long double din = x[i]-centre, dout = x[i-k]-centre, dqin = din, dqout = dout;
+      for (int q=1; q<5; q++, dqin*=din, dqout*=dout) {
+        ksum(&S[q], &C[q], dqin);
+        ksum(&S[q], &C[q], -dqout);
+      }
+    }
+    const long double a1 = (S[1]+C[1])/n, a2 = (S[2]+C[2])/n, a3 = (S[3]+C[3])/n, a4 = (S[4]+C[4])/n;
+    long double m2 = a2 - a1*a1;
+    if (m2 <= 1e-13L*a2)                                         // all equal, up to rounding of the updates
+      m2 = 0;
+    const long double m3 = a3 - 3*a1*a2 + 2*a1*a1*a1;
+    const long double m4 = a4 - 4*a1*a3 + 6*a1*a1*a2 - 3*a1*a1*a1*a1;
+    ans->dbl_v[i] = momentstat(kurt, n, m2, m3, m4);
+  }
+}
+
+/* statistic of window w[0..n-1] from scratch, buf is n doubles of the calling thread
+ * c is the position within the window of the observation ranked by rank
+ */
+static double wstat(rollfun_t rfun, const double *w, int n, int c, double p, bool narm, double *buf) {
+  int m = 0, nna = 0, nnan = 0;
+  for (int j=0; j<n; j++) {
+    if (ISNAN(w[j])) {
+      if (ISNA(w[j])) nna++; else nnan++;
+    } else {
+      buf[m++] = w[j];
+    }
+  }
+  if (rfun==UNIQUEN) {
+    qsort(buf, m, sizeof(*buf), dcmp);
+    int d = 0;
+    for (int j=0; j<m; j++) {
+      if (!j || buf[j]!=buf[j-1]) d++;
+    }
+    return d + (narm ? 0 : (nna>0) + (nnan>0));
+  }
+  if (!narm && (nna || nnan)) {
+    if (rfun==SKEW || rfun==KURT)
+      return nna ? NA_REAL : R_NaN;
+    return NA_REAL;
+  }
+  switch (rfun) {
+  case QUANTILE : {
+    if (!m)
+      return NA_REAL;
+    const double index = 1 + (m-1)*p;
+    const int lo = (int)floor(index), hi = (int)ceil(index);
+    double qs = dquickselectk(buf, m, 0, lo-1);
+    if (index > lo) {
+      const double xhi = dquickselectk(buf, m, lo, hi-1);
+      if (xhi != qs) {
+        const double h = index - lo;
+        qs = (1 - h) * qs + h * xhi;
+      }
+    }
+    return qs;
+  }
+  case RANK : {
+    if (ISNAN(w[c]))
+      return NA_REAL;
+    int less = 0, eq = 0;
+    for (int j=0; j<m; j++) {
+      less += buf[j] < w[c];
+      eq += buf[j] == w[c];
+    }
+    return less + (eq+1)/2.0;
+  }
+  case SKEW : case KURT : {
+    if (m < (rfun==KURT ? 4 : 3))
+      return NA_REAL;
+    long double wsum = 0;
+    for (int j=0; j<m; j++) wsum += buf[j];
+    if (!R_FINITE((double) wsum))
+      return R_NaN;
+    const long double wmean = wsum/m;
+    long double m2 = 0, m3 = 0, m4 = 0;
+    for (int j=0; j<m; j++) {
+      long double d = buf[j]-wmean, d2 = d*d;
+      m2 += d2; m3 += d2*d; m4 += d2*d2;
+    }
+    return momentstat(rfun==KURT, m, m2/m, m3/m, m4/m);
+  }
+  default: // # nocov
+    return NA_REAL; // # nocov
+  }
+}
+
+/* quantile, rank, uniqueN, skew and kurt - exact
+ * loop in parallel for each element of x and compute the statistic of its window from scratch
+ * ka NULL: window k of every observation, ka not NULL: adaptive window of each observation
+ */
+void frollstatExact(rollfun_t rfun, const double *x, uint64_t nx, ans_t *ans, int k, const int *ka, int off, double p, double fill, bool narm, int hasnf, bool verbose) {
+  if (verbose)
+    snprintf(end(ans->message[0]), 500, _("%s: running %s in parallel for input length %"PRIu64", window %d, hasnf %d, narm %d\n"), "frollstatExact", statname(rfun), (uint64_t)nx, ka ? -1 : k, hasnf, (int)narm);
+  if (!ka && (rfun==SKEW || rfun==KURT) && k < (rfun==KURT ? 4 : 3)) { // as in frollmomentFast
+    if (verbose)
+      snprintf(end(ans->message[0]), 500, _("%s: window width of size %d, returning all NA vector\n"), __func__, k);
+    for (uint64_t i=0; i<nx; i++) {
+      ans->dbl_v[i] = NA_REAL;
+    }
+    return;
+  }
+  int maxk = k;
+  if (ka) {
+    maxk = 0;
+    for (uint64_t i=0; i<nx; i++) {
+      if (ka[i] > maxk && i+1 >= ka[i]) maxk = ka[i];
+    }
+  }
+  int nth = getDTthreads(nx, true);
+  double *buf = malloc(sizeof(*buf) * (maxk ? maxk : 1) * nth);
+  if (!buf) { // # nocov start
+    ansSetMsg(ans, 3, "%s: Unable to allocate memory for buf", __func__); // raise error
+    return;
+  } // # nocov end
+  #pragma omp parallel for num_threads(nth)
+  for (uint64_t i=0; i<nx; i++) {
+    const int ki = ka ? ka[i] : k;
+    if (i+1 < ki) {
+      ans->dbl_v[i] = fill;
+    } else if (!ki) {
+      ans->dbl_v[i] = rfun==UNIQUEN ? 0.0 : NA_REAL;
+    } else {
+      ans->dbl_v[i] = wstat(rfun, &x[i+1-ki], ki, ka ? ki-1 : off, p, narm, &buf[(size_t)omp_get_thread_num()*maxk]);
+    }
+  }
+  free(buf);
+}
+
+/* rolling fun router for quantile, skew, kurt, rank and uniqueN, called by frollfun and frolladaptivefun
+ * off is the position within the window of the observation ranked by rank, from align, see frollfun
+ */
+void frollfunStat(rollfun_t rfun, unsigned int algo, const double *x, uint64_t nx, ans_t *ans, int k, const int *ka, int off, double p, double fill, bool narm, int hasnf, bool verbose, bool par) {
+  if (algo==0 && (rfun==SKEW || rfun==KURT)) {
+    if (!ka) {
+      frollmomentFast(rfun==KURT, x, nx, ans, k, fill, narm, hasnf, verbose);
+      return;
+    }
+    if (verbose)
+      snprintf(end(ans->message[0]), 500, _("%s: algo %u not implemented for adaptive %s, fall back to %u\n"), __func__, algo, statname(rfun), (unsigned int) 1);
+  } else if (algo==0 && nx <= INT_MAX) {                        // ranks are int
+    frollorderFast(rfun, x, nx, ans, k, ka, off, p, fill, narm, hasnf, verbose, par);
+    return;
+  }
+  frollstatExact(rfun, x, nx, ans, k, ka, off, p, fill, narm, hasnf, verbose);
+}
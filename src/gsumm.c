@@ -15,6 +15,10 @@ static char *gx=NULL;
 static size_t nBatch, batchSize, lastBatchSize;
 static int *counts, *tmpcounts;
 
+// for fused multi-aggregates, see gfusedprepare
+static SEXP gfusedcache = NULL;  // list of list(x, na.rm, results); protected by gforce() for the duration of eval(jsub)
+static SEXP gfusedprepare(SEXP env, SEXP jsub);
+
 // for gmedian
 static int maxgrpn = 0;
 static int *oo = NULL;
@@ -205,16 +209,20 @@ SEXP gforce(SEXP env, SEXP jsub, SEXP o, SEXP f, SEXP l, SEXP irowsArg) {
   oo = INTEGER(o);
   ff = INTEGER(f);
 
+  gfusedcache = NULL;
+  SEXP fusedcache = PROTECT(gfusedprepare(env, jsub));
+  gfusedcache = isNull(fusedcache) ? NULL : fusedcache;
   SEXP ans = PROTECT( eval(jsub, env) );
+  gfusedcache = NULL;
   if (verbose) { Rprintf(_("gforce eval took %.3f\n"), wallclock()-started); started=wallclock(); }
   // if this eval() fails with R error, R will release grp for us. Which is why we use R_alloc above.
   if (isVectorAtomic(ans)) {
     SEXP tt = PROTECT(allocVector(VECSXP, 1));
     SET_VECTOR_ELT(tt, 0, ans);
-    UNPROTECT(2);
+    UNPROTECT(3);
     return tt;
   }
-  UNPROTECT(1);
+  UNPROTECT(2);
   return ans;
 }
 
@@ -345,6 +353,258 @@ void *gather(SEXP x, bool *anyNA)
   return gx;
 }
 
+// Fused multi-aggregate. When j applies several of sum/mean/min/max/var/sd to the same column, e.g.
+//   DT[, .(sum(x), mean(x), sd(x), min(x), max(x), .N), by=g]
+// gforce() gathers that column once and computes all requested statistics in a single sweep per batch (plus a second
+// sweep over the already gathered values for var/sd). The results are cached and then simply returned by the g* calls
+// made while evaluating jsub, so jsub itself (and the verbose output describing it) is left unchanged.
+enum { GF_SUM=0, GF_MEAN, GF_MIN, GF_MAX, GF_VAR, GF_SD, GF_NFUN };
+static const char *gfusednames[GF_NFUN] = {"gsum", "gmean", "gmin", "gmax", "gvar", "gsd"};
+static int gfusedfun(SEXP q)
+{
+  // which of gfusednames is q; i.e. g*(col) or g*(col, <TRUE|FALSE>) as left by .gforce_jsub. -1 otherwise
+  if (TYPEOF(q)!=LANGSXP || TYPEOF(CAR(q))!=SYMSXP || TYPEOF(CADR(q))!=SYMSXP) return -1;
+  const int len = length(q);
+  if (len!=2 && !(len==3 && IS_TRUE_OR_FALSE(CADDR(q)))) return -1;
+  for (int i=0; i<GF_NFUN; ++i) if (CAR(q)==install(gfusednames[i])) return i;
+  return -1;
+}
+
+static SEXP gfusedlookup(SEXP x, bool narm, int fun)
+{
+  if (gfusedcache==NULL) return NULL;
+  for (int i=0; i<LENGTH(gfusedcache); ++i) {
+    const SEXP entry = VECTOR_ELT(gfusedcache, i);
+    if (isNull(entry)) break;
+    if (VECTOR_ELT(entry, 0)==x && LOGICAL(VECTOR_ELT(entry, 1))[0]==narm) {
+      const SEXP ans = VECTOR_ELT(VECTOR_ELT(entry, 2), fun);
+      if (isNull(ans)) return NULL;
+      SET_VECTOR_ELT(VECTOR_ELT(entry, 2), fun, R_NilValue);  // consumed; a repeated call, e.g. list(sum(x), sum(x)), must not share the same vector
+      return ans;
+    }
+  }
+  return NULL;
+}
+
+static SEXP gfused(SEXP x, const bool narm, const bool *want)
+{
+  double started = wallclock();
+  const bool verbose = GetVerbose();
+  const bool isInt = TYPEOF(x)!=REALSXP;
+  const bool needvar = want[GF_VAR] || want[GF_SD];
+  const bool needsum = want[GF_SUM] || want[GF_MEAN] || needvar;
+  const bool needmin = want[GF_MIN], needmax = want[GF_MAX];
+  bool anyNA = false;
+  const void *gxv = gather(x, &anyNA);
+  // per group accumulators; R_alloc so they are released if anything below errors
+  int *restrict nna = (int *)R_alloc(ngrp, sizeof(*nna));  // non-NA count
+  memset(nna, 0, ngrp*sizeof(*nna));
+  int64_t *restrict isum = NULL;
+  double *restrict dsum = NULL;
+  if (needsum) {
+    if (isInt) { isum = (int64_t *)R_alloc(ngrp, sizeof(*isum)); memset(isum, 0, ngrp*sizeof(*isum)); }
+    else       { dsum = (double *)R_alloc(ngrp, sizeof(*dsum));  memset(dsum, 0, ngrp*sizeof(*dsum)); }
+  }
+  SEXP ans = PROTECT(allocVector(VECSXP, GF_NFUN));
+  // min and max are written straight into their answer vectors, with the same initial values and update rules as gminmax
+  if (needmin) SET_VECTOR_ELT(ans, GF_MIN, allocVector(isInt ? INTSXP : REALSXP, ngrp));
+  if (needmax) SET_VECTOR_ELT(ans, GF_MAX, allocVector(isInt ? INTSXP : REALSXP, ngrp));
+  if (isInt) {
+    const int *restrict gx = gxv;
+    int *restrict mn = needmin ? INTEGER(VECTOR_ELT(ans, GF_MIN)) : NULL;
+    int *restrict mx = needmax ? INTEGER(VECTOR_ELT(ans, GF_MAX)) : NULL;
+    for (int i=0; i<ngrp; ++i) {
+      if (needmin) mn[i] = narm ? NA_INTEGER : INT_MAX;
+      if (needmax) mx[i] = narm ? NA_INTEGER : INT_MIN+1;
+    }
+    #pragma omp parallel for num_threads(getDTthreads(highSize, false))
+    for (int h=0; h<highSize; h++) {   // very important that high is first loop here
+      const int off = h<<bitshift;
+      for (int b=0; b<nBatch; b++) {
+        const int pos = counts[ b*highSize + h ];
+        const int howMany = ((h==highSize-1) ? (b==nBatch-1?lastBatchSize:batchSize) : counts[ b*highSize + h + 1 ]) - pos;
+        const int *my_gx = gx + b*batchSize + pos;
+        const uint16_t *my_low = low + b*batchSize + pos;
+        for (int i=0; i<howMany; i++) {
+          const int g = off + my_low[i];
+          const int elem = my_gx[i];
+          if (elem==NA_INTEGER) {
+            if (!narm) {
+              if (needmin) mn[g] = NA_INTEGER;
+              if (needmax) mx[g] = NA_INTEGER;
+            }
+            continue;
+          }
+          nna[g]++;
+          if (needsum) isum[g] += elem;
+          if (needmin && (narm ? (mn[g]==NA_INTEGER || elem<mn[g]) : (mn[g]!=NA_INTEGER && elem<mn[g]))) mn[g] = elem;
+          if (needmax && (narm ? (mx[g]==NA_INTEGER || !(elem<mx[g])) : (mx[g]!=NA_INTEGER && !(elem<mx[g])))) mx[g] = elem;
+        }
+      }
+    }
+  } else {
+    const double *restrict gx = gxv;
+    double *restrict mn = needmin ? REAL(VECTOR_ELT(ans, GF_MIN)) : NULL;
+    double *restrict mx = needmax ? REAL(VECTOR_ELT(ans, GF_MAX)) : NULL;
+    for (int i=0; i<ngrp; ++i) {
+      if (needmin) mn[i] = narm ? NA_REAL : R_PosInf;
+      if (needmax) mx[i] = narm ? NA_REAL : R_NegInf;
+    }
+    #pragma omp parallel for num_threads(getDTthreads(highSize, false))
+    for (int h=0; h<highSize; h++) {
+      const int off = h<<bitshift;
+      for (int b=0; b<nBatch; b++) {
+        const int pos = counts[ b*highSize + h ];
+        const int howMany = ((h==highSize-1) ? (b==nBatch-1?lastBatchSize:batchSize) : counts[ b*highSize + h + 1 ]) - pos;
+        const double *my_gx = gx + b*batchSize + pos;
+        const uint16_t *my_low = low + b*batchSize + pos;
+        for (int i=0; i<howMany; i++) {
+          const int g = off + my_low[i];
+          const double elem = my_gx[i];
+          if (ISNAN(elem)) {
+            if (!narm) {
+              if (needsum) dsum[g] += elem;  // let NA propagate, as gsum and gmean do
+              if (needmin && !ISNAN(mn[g])) mn[g] = elem;  // the first NA or NaN observed in the group sticks, as in gminmax
+              if (needmax && !ISNAN(mx[g])) mx[g] = elem;
+            }
+            continue;
+          }
+          nna[g]++;
+          if (needsum) dsum[g] += elem;
+          if (needmin && (narm ? (ISNAN(mn[g]) || elem<mn[g]) : (!ISNAN(mn[g]) && elem<mn[g]))) mn[g] = elem;
+          if (needmax && (narm ? (ISNAN(mx[g]) || !(elem<mx[g])) : (!ISNAN(mx[g]) && !(elem<mx[g])))) mx[g] = elem;
+        }
+      }
+    }
+  }
+  if (needvar) {
+    // second sweep over the gathered values: sum of residuals and of squared residuals around the first pass mean, i.e.
+    // the same corrected two-pass algorithm as gvarsd1 but without re-reading x through o
+    long double *restrict rs = (long double *)R_alloc(ngrp, sizeof(*rs));
+    long double *restrict rss = (long double *)R_alloc(ngrp, sizeof(*rss));
+    double *restrict m = (double *)R_alloc(ngrp, sizeof(*m));
+    for (int i=0; i<ngrp; ++i) {
+      rs[i] = rss[i] = 0.0;
+      m[i] = nna[i] ? (isInt ? (double)isum[i] : dsum[i]) / nna[i] : NA_REAL;
+    }
+    #pragma omp parallel for num_threads(getDTthreads(highSize, false))
+    for (int h=0; h<highSize; h++) {
+      const int off = h<<bitshift;
+      for (int b=0; b<nBatch; b++) {
+        const int pos = counts[ b*highSize + h ];
+        const int howMany = ((h==highSize-1) ? (b==nBatch-1?lastBatchSize:batchSize) : counts[ b*highSize + h + 1 ]) - pos;
+        const uint16_t *my_low = low + b*batchSize + pos;
+        for (int i=0; i<howMany; i++) {
+          const int g = off + my_low[i];
+          double elem;
+          if (isInt) {
+            const int ielem = ((const int *)gxv)[b*batchSize + pos + i];
+            if (ielem==NA_INTEGER) continue;
+            elem = ielem;
+          } else {
+            elem = ((const double *)gxv)[b*batchSize + pos + i];
+            if (ISNAN(elem)) continue;
+          }
+          const long double d = elem - m[g];
+          rs[g] += d;
+          rss[g] += d*d;
+        }
+      }
+    }
+    SEXP var = want[GF_VAR] ? allocVector(REALSXP, ngrp) : R_NilValue;
+    SET_VECTOR_ELT(ans, GF_VAR, var);
+    SEXP sd = want[GF_SD] ? allocVector(REALSXP, ngrp) : R_NilValue;
+    SET_VECTOR_ELT(ans, GF_SD, sd);
+    for (int i=0; i<ngrp; ++i) {
+      double v = NA_REAL;
+      const int n = nna[i];
+      if (grpsize[i]>1 && !(n!=grpsize[i] && (!narm || n<=1)))
+        v = (double)((rss[i] - rs[i]*rs[i]/n) / (n-1));
+      if (want[GF_VAR]) REAL(var)[i] = v;
+      if (want[GF_SD]) REAL(sd)[i] = ISNAN(v) ? v : SQRTL(v);
+    }
+  }
+  if (want[GF_MEAN]) {
+    SEXP mean = allocVector(REALSXP, ngrp);
+    SET_VECTOR_ELT(ans, GF_MEAN, mean);
+    double *restrict meanp = REAL(mean);
+    for (int i=0; i<ngrp; ++i) {
+      const int n = narm ? nna[i] : grpsize[i];
+      if (isInt) meanp[i] = (!narm && nna[i]!=grpsize[i]) ? NA_REAL : (double)isum[i] / n;
+      else       meanp[i] = dsum[i] / n;
+    }
+    copyMostAttrib(x, mean);
+  }
+  if (want[GF_SUM]) {
+    SEXP sum;
+    if (isInt) {
+      bool overflow = false;
+      for (int i=0; i<ngrp && !overflow; ++i) overflow = isum[i]>INT_MAX || isum[i]<=NA_INTEGER;
+      if (overflow) warning(_("The sum of an integer column for a group was more than type 'integer' can hold so the result has been coerced to 'numeric' automatically for convenience."));
+      SET_VECTOR_ELT(ans, GF_SUM, sum=allocVector(overflow ? REALSXP : INTSXP, ngrp));
+      for (int i=0; i<ngrp; ++i) {
+        const bool na = !narm && nna[i]!=grpsize[i];
+        if (overflow) REAL(sum)[i] = na ? NA_REAL : (double)isum[i];
+        else INTEGER(sum)[i] = na ? NA_INTEGER : (int)isum[i];
+      }
+    } else {
+      SET_VECTOR_ELT(ans, GF_SUM, sum=allocVector(REALSXP, ngrp));
+      memcpy(REAL(sum), dsum, ngrp*sizeof(double));
+    }
+    copyMostAttrib(x, sum);
+  }
+  if (needmin) copyMostAttrib(x, VECTOR_ELT(ans, GF_MIN));
+  if (needmax) copyMostAttrib(x, VECTOR_ELT(ans, GF_MAX));
+  if (verbose) Rprintf(_("gforce fused %d aggregates over one gather of the column in %.3fs\n"), want[GF_SUM]+want[GF_MEAN]+want[GF_MIN]+want[GF_MAX]+want[GF_VAR]+want[GF_SD], wallclock()-started);
+  UNPROTECT(1);
+  return ans;
+}
+
+static SEXP gfusedprepare(SEXP env, SEXP jsub)
+{
+  // find columns in list(...) which are the argument of two or more of gfusednames with the same na.rm, and compute those up front
+  if (TYPEOF(jsub)!=LANGSXP || CAR(jsub)!=install("list")) return R_NilValue;
+  const int nargs = length(jsub)-1;
+  if (nargs<2) return R_NilValue;
+  SEXP *sym = (SEXP *)R_alloc(nargs, sizeof(*sym));
+  bool *narm = (bool *)R_alloc(nargs, sizeof(*narm));
+  int *fun = (int *)R_alloc(nargs, sizeof(*fun));
+  int ncand = 0;
+  for (SEXP a=CDR(jsub); a!=R_NilValue; a=CDR(a)) {
+    const SEXP q = CAR(a);
+    const int f = gfusedfun(q);
+    if (f<0) continue;
+    sym[ncand] = CADR(q);
+    narm[ncand] = length(q)==3 && LOGICAL(CADDR(q))[0];
+    fun[ncand++] = f;
+  }
+  if (ncand<2) return R_NilValue;
+  SEXP cache = PROTECT(allocVector(VECSXP, ncand));
+  int nfused = 0;
+  for (int i=0; i<ncand; ++i) {
+    if (sym[i]==NULL) continue;  // already part of an earlier candidate
+    bool want[GF_NFUN] = {false};
+    int nwant = 0;
+    for (int j=i; j<ncand; ++j) {
+      if (sym[j]!=sym[i] || narm[j]!=narm[i]) continue;
+      if (!want[fun[j]]) { want[fun[j]]=true; nwant++; }
+      if (j>i) sym[j] = NULL;
+    }
+    if (nwant<2) continue;
+    const SEXP x = eval(sym[i], env);
+    // classed columns (factor, integer64, Date, etc.) and non-numeric types go through the individual g* functions as before
+    if ((TYPEOF(x)!=INTSXP && TYPEOF(x)!=LGLSXP && TYPEOF(x)!=REALSXP) || OBJECT(x)) continue;
+    if (nrow != ((irowslen==-1) ? length(x) : irowslen)) continue;  // let the g* functions raise the error
+    SEXP entry = allocVector(VECSXP, 3);
+    SET_VECTOR_ELT(cache, nfused++, entry);
+    SET_VECTOR_ELT(entry, 0, x);
+    SET_VECTOR_ELT(entry, 1, ScalarLogical(narm[i]));
+    SET_VECTOR_ELT(entry, 2, gfused(x, narm[i], want));
+  }
+  UNPROTECT(1);
+  return cache;
+}
+
 SEXP gsum(SEXP x, SEXP narmArg)
 {
   if (!IS_TRUE_OR_FALSE(narmArg))
@@ -352,6 +612,8 @@ SEXP gsum(SEXP x, SEXP narmArg)
   const bool narm = LOGICAL(narmArg)[0];
   if (inherits(x, "factor"))
     error(_("%s is not meaningful for factors."), "sum");
+  SEXP fused = gfusedlookup(x, narm, GF_SUM);
+  if (fused) return fused;
   const int n = (irowslen == -1) ? length(x) : irowslen;
   double started = wallclock();
   const bool verbose=GetVerbose();
@@ -586,6 +848,8 @@ SEXP gmean(SEXP x, SEXP narmArg)
   if (!IS_TRUE_OR_FALSE(narmArg))
     error(_("%s must be TRUE or FALSE"), "na.rm");
   const bool narm = LOGICAL(narmArg)[0];
+  SEXP fused = gfusedlookup(x, narm, GF_MEAN);
+  if (fused) return fused;
   const int n = (irowslen == -1) ? length(x) : irowslen;
   double started = wallclock();
   const bool verbose=GetVerbose();
@@ -734,6 +998,8 @@ static SEXP gminmax(SEXP x, SEXP narm, const bool min)
   if (!isVectorAtomic(x)) error(_("GForce min/max can only be applied to columns, not .SD or similar. To find min/max of all items in a list such as .SD, either add the prefix base::min(.SD) or turn off GForce optimization using options(datatable.optimize=1). More likely, you may be looking for 'DT[,lapply(.SD,min),by=,.SDcols=]'"));
   if (inherits(x, "factor") && !inherits(x, "ordered"))
     error(_("%s is not meaningful for factors."), min?"min":"max");
+  SEXP fused = gfusedlookup(x, LOGICAL(narm)[0], min ? GF_MIN : GF_MAX);
+  if (fused) return fused;
   const bool nosubset = irowslen==-1;
   const int n = nosubset ? length(x) : irowslen;
   //clock_t start = clock();
@@ -1027,6 +1293,8 @@ static SEXP gvarsd1(SEXP x, SEXP narmArg, bool isSD)
   if (!isVectorAtomic(x)) error(_("GForce var/sd can only be applied to columns, not .SD or similar. For the full covariance matrix of all items in a list such as .SD, either add the prefix stats::var(.SD) (or stats::sd(.SD)) or turn off GForce optimization using options(datatable.optimize=1). Alternatively, if you only need the diagonal elements, 'DT[,lapply(.SD,var),by=,.SDcols=]' is the optimized way to do this."));
   if (inherits(x, "factor"))
     error(_("%s is not meaningful for factors."), isSD ? "sd" : "var");
+  SEXP fused = gfusedlookup(x, LOGICAL(narmArg)[0], isSD ? GF_SD : GF_VAR);
+  if (fused) return fused;
   const int n = (irowslen == -1) ? length(x) : irowslen;
   if (nrow != n) error(_("nrow [%d] != length(x) [%d] in %s"), nrow, n, "gvar");
   SEXP sub, ans = PROTECT(allocVector(REALSXP, ngrp));
@@ -1222,6 +1490,9 @@ SEXP gshift(SEXP x, SEXP nArg, SEXP fillArg, SEXP typeArg) {
 
   SEXP ans = PROTECT(allocVector(VECSXP, nk)); nprotect++;
   SEXP thisfill = PROTECT(coerceAs(fillArg, x, ScalarLogical(0))); nprotect++;
+  int *off = (int *)R_alloc(ngrp, sizeof(*off)); // each group is written to its own offset so groups are shifted in parallel
+  for (int i=0, cum=0; i<ngrp; ++i) { off[i] = cum; cum += grpsize[i]; }
+  int nth = TYPEOF(x)==STRSXP ? 1 : getDTthreads(ngrp, true);  // SET_STRING_ELT is not thread safe
   for (int g=0; g<nk; g++) {
     lag = stype == LAG || stype == CYCLIC;
     int m = kd[g];
@@ -1230,13 +1501,14 @@ SEXP gshift(SEXP x, SEXP nArg, SEXP fillArg, SEXP typeArg) {
       m = m * (-1);
       lag = !lag;
     }
-    R_xlen_t ansi = 0;
     SEXP tmp;
     SET_VECTOR_ELT(ans, g, tmp=allocVector(TYPEOF(x), n));
     #define SHIFT(CTYPE, RTYPE, ASSIGN) {                                                                         \
       const CTYPE *xd = (const CTYPE *)RTYPE(x);                                                                  \
       const CTYPE fill = RTYPE(thisfill)[0];                                                                      \
+      _Pragma("omp parallel for num_threads(nth)")                                                                \
       for (int i=0; i<ngrp; ++i) {                                                                                \
+        R_xlen_t ansi = off[i];                                                                                   \
         const int grpn = grpsize[i];                                                                              \
         const int mg = cycle ? (((m-1) % grpn) + 1) : m;                                                          \
         const int thisn = MIN(mg, grpn);                                                                          \
@@ -1283,3 +1555,320 @@ SEXP gshift(SEXP x, SEXP nArg, SEXP fillArg, SEXP typeArg) {
   // consistency with plain shift(): "strip" the list in the 1-input case, for convenience
   return isVectorAtomic(x) && length(ans) == 1 ? VECTOR_ELT(ans, 0) : ans;
 }
+
+// all rows of each group in group order; i.e. x[o__] (subject to irows), for j items that return one value per row,
+// such as x*2 or fifelse(x>0, x, 0), which are evaluated once over the whole column beforehand. Each group is
+// written to its offset in the result so the groups can be copied in parallel.
+SEXP growwise(SEXP x) {
+  const bool nosubset = irowslen == -1;
+  const bool issorted = !isunsorted;
+  const int n = nosubset ? length(x) : irowslen;
+  if (nrow != n) internal_error(__func__, "nrow [%d] != length(x) [%d] in %s", nrow, n, "growwise");
+  int *off = (int *)R_alloc(ngrp, sizeof(*off));
+  for (int i=0, cum=0; i<ngrp; ++i) { off[i] = cum; cum += grpsize[i]; }
+  SEXP ans = PROTECT(allocVector(TYPEOF(x), nrow));
+  int nth = TYPEOF(x)==STRSXP ? 1 : getDTthreads(ngrp, true);  // SET_STRING_ELT is not thread safe
+  #define ROWWISE(CTYPE, RTYPE, RNA, ASSIGN) {                                                 \
+    const CTYPE *xd = (const CTYPE *)RTYPE(x);                                                \
+    _Pragma("omp parallel for num_threads(nth)")                                              \
+    for (int i=0; i<ngrp; ++i) {                                                              \
+      const int jstart = ff[i]-1, grpn = grpsize[i];                                          \
+      for (int j=0; j<grpn; ++j) {                                                            \
+        const int k = issorted ? jstart+j : oo[jstart+j]-1;                                   \
+        const CTYPE val = nosubset ? xd[k] : (irows[k]==NA_INTEGER ? RNA : xd[irows[k]-1]);   \
+        ASSIGN;                                                                               \
+      }                                                                                       \
+    }                                                                                         \
+  }
+  switch(TYPEOF(x)) {
+  case LGLSXP: case INTSXP: { int *ansd=INTEGER(ans);          ROWWISE(int,      INTEGER, NA_INTEGER,   ansd[off[i]+j]=val) } break;
+  case REALSXP: if (INHERITS(x, char_integer64)) {
+                  int64_t *ansd=(int64_t *)REAL(ans);         ROWWISE(int64_t,  REAL,    NA_INTEGER64, ansd[off[i]+j]=val) }
+                else { double *ansd=REAL(ans);                ROWWISE(double,   REAL,    NA_REAL,      ansd[off[i]+j]=val) } break;
+  case CPLXSXP: { Rcomplex *ansd=COMPLEX(ans);                ROWWISE(Rcomplex, COMPLEX, NA_CPLX,      ansd[off[i]+j]=val) } break;
+  case STRSXP:                                                ROWWISE(SEXP, STRING_PTR_RO, NA_STRING,  SET_STRING_ELT(ans,off[i]+j,val)) break;
+  default:
+    error(_("Type '%s' is not supported by GForce row-wise j. Turn off GForce optimization using options(datatable.optimize=1)"), type2char(TYPEOF(x))); // # nocov
+  }
+  copyMostAttrib(x, ans);
+  UNPROTECT(1);
+  return ans;
+}
+
+// gquantile, gmad and guniqueN copy each group's values to a buffer, as gmedian does, but do so in parallel across groups
+// with one buffer per thread. The number of threads is limited so that those buffers (maxgrpn each) total at most nrow.
+static int gbufthreads(void)
+{
+  return MAX(1, MIN(getDTthreads(ngrp, true), nrow / MAX(maxgrpn, 1)));
+}
+
+// copy the non-NA values of group i of x (integer, logical or double) into buf as double, returning how many there were
+static int gcopygrp(const void *xp, const bool isReal, const int i, double *restrict buf, bool *anyNA)
+{
+  const bool nosubset = irowslen==-1;
+  const int thisgrpsize = grpsize[i];
+  int nna = 0;
+  for (int j=0; j<thisgrpsize; ++j) {
+    int k = ff[i]+j-1;
+    if (isunsorted) k = oo[k]-1;
+    if (!nosubset) {
+      if (irows[k]==NA_INTEGER) { *anyNA=true; continue; }
+      k = irows[k]-1;
+    }
+    if (isReal) {
+      const double elem = ((const double *)xp)[k];
+      if (ISNAN(elem)) *anyNA=true; else buf[nna++] = elem;
+    } else {
+      const int elem = ((const int *)xp)[k];
+      if (elem==NA_INTEGER) *anyNA=true; else buf[nna++] = elem;
+    }
+  }
+  return nna;
+}
+
+// type 7 quantiles (the default of stats::quantile) of v[0..n-1] at probs[pord[0]] <= probs[pord[1]] <= ..., written to
+// ans[pord[p]]. Each order statistic is selected from the part of v not yet known to be smaller, reusing earlier partitioning.
+static void gquantile7(double *v, const int n, const double *probs, const int *pord, const int np, double *ans)
+{
+  int l = 0;
+  for (int p=0; p<np; ++p) {
+    const int w = pord[p];
+    if (n==0) { ans[w] = NA_REAL; continue; }
+    const double index = 1 + (n-1)*probs[w];
+    const int lo = (int)floor(index), hi = (int)ceil(index);
+    double qs = dquickselectk(v, n, l, lo-1);
+    l = lo-1;
+    if (index > lo) {
+      const double xhi = dquickselectk(v, n, lo, hi-1);  // smallest of v[lo..n-1]
+      if (xhi != qs) {
+        const double h = index - lo;
+        qs = (1 - h) * qs + h * xhi;
+      }
+    }
+    ans[w] = qs;
+  }
+}
+
+// returns length(probs) values per group, one group after another; i.e. as many rows per group as probs
+SEXP gquantile(SEXP x, SEXP probsArg, SEXP narmArg)
+{
+  if (!IS_TRUE_OR_FALSE(narmArg))
+    error(_("%s must be TRUE or FALSE"), "na.rm");
+  if (!isVectorAtomic(x)) error(_("GForce quantile can only be applied to columns, not .SD or similar. Either add the prefix stats::quantile(.) or turn off GForce optimization using options(datatable.optimize=1)"));
+  if (inherits(x, "factor") || INHERITS(x, char_integer64) || !(isReal(x) || isInteger(x) || isLogical(x)))
+    error(_("Type '%s' is not supported by GForce %s. Either add the prefix %s or turn off GForce optimization using options(datatable.optimize=1)"), type2char(TYPEOF(x)), "quantile (gquantile)", "stats::quantile(.)");
+  if (!isReal(probsArg)) internal_error(__func__, "probs must be double"); // # nocov
+  const bool narm = LOGICAL(narmArg)[0];
+  const int n = (irowslen == -1) ? length(x) : irowslen;
+  if (nrow != n) error(_("nrow [%d] != length(x) [%d] in %s"), nrow, n, "gquantile");
+  const int np = length(probsArg);
+  const double *probs = REAL(probsArg);
+  for (int p=0; p<np; ++p) if (ISNAN(probs[p]) || probs[p]<0 || probs[p]>1) error(_("'probs' outside [0,1]"));
+  int *pord = (int *)R_alloc(np, sizeof(*pord));  // order of probs; insertion sort as there are only a few
+  for (int p=0; p<np; ++p) {
+    int q = p;
+    for (; q>0 && probs[pord[q-1]]>probs[p]; --q) pord[q] = pord[q-1];
+    pord[q] = p;
+  }
+  SEXP ans = PROTECT(allocVector(REALSXP, (R_xlen_t)ngrp*np));
+  double *ansd = REAL(ans);
+  int nth = gbufthreads();
+  double *buf = (double *)R_alloc((size_t)nth*maxgrpn, sizeof(*buf));
+  const void *xp = DATAPTR_RO(x);
+  const bool isReal = TYPEOF(x)==REALSXP;
+  bool anyNA = false;
+  #pragma omp parallel for num_threads(nth) schedule(dynamic, 256)
+  for (int i=0; i<ngrp; ++i) {
+    double *my_buf = buf + (size_t)omp_get_thread_num()*maxgrpn;
+    bool my_anyNA = false;
+    const int nna = gcopygrp(xp, isReal, i, my_buf, &my_anyNA);
+    if (my_anyNA && !narm) { anyNA = true; continue; }  // naked write ok, see gather
+    gquantile7(my_buf, nna, probs, pord, np, ansd + (int64_t)i*np);
+  }
+  if (anyNA) error(_("missing values and NaN's not allowed if 'na.rm' is FALSE"));  // as stats::quantile
+  UNPROTECT(1);
+  return ans;
+}
+
+SEXP gmad(SEXP x, SEXP constantArg, SEXP narmArg)
+{
+  if (!IS_TRUE_OR_FALSE(narmArg))
+    error(_("%s must be TRUE or FALSE"), "na.rm");
+  if (!isVectorAtomic(x)) error(_("GForce mad can only be applied to columns, not .SD or similar. Either add the prefix stats::mad(.) or turn off GForce optimization using options(datatable.optimize=1)"));
+  if (inherits(x, "factor") || INHERITS(x, char_integer64) || !(isReal(x) || isInteger(x) || isLogical(x)))
+    error(_("Type '%s' is not supported by GForce %s. Either add the prefix %s or turn off GForce optimization using options(datatable.optimize=1)"), type2char(TYPEOF(x)), "mad (gmad)", "stats::mad(.)");
+  if (!isReal(constantArg) || LENGTH(constantArg)!=1) internal_error(__func__, "constant must be a double of length 1"); // # nocov
+  const bool narm = LOGICAL(narmArg)[0];
+  const double constant = REAL(constantArg)[0];
+  const int n = (irowslen == -1) ? length(x) : irowslen;
+  if (nrow != n) error(_("nrow [%d] != length(x) [%d] in %s"), nrow, n, "gmad");
+  SEXP ans = PROTECT(allocVector(REALSXP, ngrp));
+  double *ansd = REAL(ans);
+  int nth = gbufthreads();
+  double *buf = (double *)R_alloc((size_t)nth*maxgrpn, sizeof(*buf));
+  const void *xp = DATAPTR_RO(x);
+  const bool isReal = TYPEOF(x)==REALSXP;
+  #pragma omp parallel for num_threads(nth) schedule(dynamic, 256)
+  for (int i=0; i<ngrp; ++i) {
+    double *my_buf = buf + (size_t)omp_get_thread_num()*maxgrpn;
+    bool anyNA = false;
+    const int nna = gcopygrp(xp, isReal, i, my_buf, &anyNA);
+    if (anyNA && !narm) { ansd[i] = NA_REAL; continue; }
+    const double center = dquickselect(my_buf, nna);  // median
+    for (int j=0; j<nna; ++j) my_buf[j] = fabs(my_buf[j]-center);
+    ansd[i] = constant * dquickselect(my_buf, nna);
+  }
+  UNPROTECT(1);
+  return ans;
+}
+
+static int cmp_uint64(const void *a, const void *b)
+{
+  const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+// exact by sorting each group's keys; with approx=TRUE, groups with more than HLL_REGISTERS values use HyperLogLog instead
+SEXP guniqueN(SEXP x, SEXP narmArg, SEXP approxArg)
+{
+  if (!IS_TRUE_OR_FALSE(narmArg))
+    error(_("%s must be TRUE or FALSE"), "na.rm");
+  if (!IS_TRUE_OR_FALSE(approxArg))
+    error(_("%s must be TRUE or FALSE"), "approx");
+  if (!isVectorAtomic(x)) error(_("GForce uniqueN can only be applied to columns, not .SD or similar. Either add the prefix data.table::uniqueN(.) or turn off GForce optimization using options(datatable.optimize=1)"));
+  const bool narm = LOGICAL(narmArg)[0], approx = LOGICAL(approxArg)[0];
+  const int n = (irowslen == -1) ? length(x) : irowslen;
+  if (nrow != n) error(_("nrow [%d] != length(x) [%d] in %s"), nrow, n, "guniqueN");
+  int nprotect = 0;
+  const bool isInt64 = INHERITS(x, char_integer64);
+  switch(TYPEOF(x)) {
+  case LGLSXP: case INTSXP: case REALSXP: break;
+  case STRSXP: x = PROTECT(coerceUtf8IfNeeded(x)); nprotect++; break;  // pointer equality is then string equality
+  default:
+    error(_("Type '%s' is not supported by GForce %s. Either add the prefix %s or turn off GForce optimization using options(datatable.optimize=1)"), type2char(TYPEOF(x)), "uniqueN (guniqueN)", "data.table::uniqueN(.)");
+  }
+  const int type = TYPEOF(x);
+  const void *xp = DATAPTR_RO(x);
+  SEXP ans = PROTECT(allocVector(INTSXP, ngrp)); nprotect++;
+  int *ansd = INTEGER(ans);
+  int nth = gbufthreads();
+  uint64_t *buf = (uint64_t *)R_alloc((size_t)nth*maxgrpn, sizeof(*buf));
+  uint8_t *reg = approx ? (uint8_t *)R_alloc((size_t)nth*HLL_REGISTERS, sizeof(*reg)) : NULL;
+  const bool nosubset = irowslen==-1;
+  #pragma omp parallel for num_threads(nth) schedule(dynamic, 256)
+  for (int i=0; i<ngrp; ++i) {
+    uint64_t *my_buf = buf + (size_t)omp_get_thread_num()*maxgrpn;
+    const int thisgrpsize = grpsize[i];
+    int nkey = 0;
+    bool anyNA = false;
+    for (int j=0; j<thisgrpsize; ++j) {
+      int k = ff[i]+j-1;
+      if (isunsorted) k = oo[k]-1;
+      if (!nosubset) {
+        if (irows[k]==NA_INTEGER) { anyNA=true; continue; }
+        k = irows[k]-1;
+      }
+      uint64_t key;
+      bool isna;
+      switch(type) {
+      case REALSXP:
+        if (isInt64) { key = (uint64_t)((const int64_t *)xp)[k]; isna = (int64_t)key==NA_INTEGER64; }
+        else { const double elem = ((const double *)xp)[k]; key = uniqueNdkey(elem); isna = ISNAN(elem); }
+        break;
+      case STRSXP: { const SEXP elem = ((const SEXP *)xp)[k]; key = (uint64_t)(uintptr_t)elem; isna = elem==NA_STRING; } break;
+      default: { const int elem = ((const int *)xp)[k]; key = (uint64_t)(uint32_t)elem; isna = elem==NA_INTEGER; }
+      }
+      if (isna) { anyNA=true; continue; }  // NA (and NaN) keys are counted below, as one value each when !narm
+      my_buf[nkey++] = key;
+    }
+    int count;
+    if (approx && nkey > HLL_REGISTERS) {
+      uint8_t *my_reg = reg + (size_t)omp_get_thread_num()*HLL_REGISTERS;
+      memset(my_reg, 0, HLL_REGISTERS);
+      for (int j=0; j<nkey; ++j) hlladd(my_reg, my_buf[j]);
+      const double E = hllestimate(my_reg);
+      count = E >= INT_MAX ? INT_MAX : (int)nearbyint(E);
+    } else {
+      qsort(my_buf, nkey, sizeof(*my_buf), cmp_uint64);
+      count = nkey>0;
+      for (int j=1; j<nkey; ++j) count += my_buf[j]!=my_buf[j-1];
+    }
+    if (anyNA && !narm) {
+      // NA and NaN are distinct values to uniqueN(); count each that is present in the group
+      bool seenNA=false, seenNaN=false;
+      for (int j=0; j<thisgrpsize && !(seenNA && seenNaN); ++j) {
+        int k = ff[i]+j-1;
+        if (isunsorted) k = oo[k]-1;
+        if (!nosubset) {
+          if (irows[k]==NA_INTEGER) { seenNA=true; continue; }
+          k = irows[k]-1;
+        }
+        if (type==REALSXP && !isInt64 && ISNAN(((const double *)xp)[k])) {
+          if (ISNA(((const double *)xp)[k])) seenNA=true; else seenNaN=true;
+        } else if (type==REALSXP && isInt64) {
+          if (((const int64_t *)xp)[k]==NA_INTEGER64) seenNA=true;
+        } else if (type==STRSXP) {
+          if (((const SEXP *)xp)[k]==NA_STRING) seenNA=true;
+        } else if (type!=REALSXP) {
+          if (((const int *)xp)[k]==NA_INTEGER) seenNA=true;
+        }
+      }
+      count += seenNA + seenNaN;
+    }
+    ansd[i] = count;
+  }
+  UNPROTECT(nprotect);
+  return ans;
+}
+
+// frollmean(x, n), frollsum(x, n), etc by group: x (and n when adaptive) are gathered into group order once as growwise()
+// does, and frollfunR() then rolls every group on its own in one parallel sweep over the groups, writing straight into
+// one result per column and window instead of dogroups() calling froll once for each group
+SEXP gfroll(SEXP fun, SEXP x, SEXP n, SEXP fill, SEXP algo, SEXP align, SEXP narm, SEXP hasnf, SEXP adaptive, SEXP p) {
+  if (!isLogical(x) && !isInteger(x) && !isReal(x))
+    error(_("Type '%s' is not supported by GForce froll. Either add the namespace prefix (e.g. data.table::frollmean(.)) or turn off GForce optimization using options(datatable.optimize=1)"), type2char(TYPEOF(x)));
+  if (!IS_TRUE_OR_FALSE(adaptive))
+    error(_("%s must be TRUE or FALSE"), "adaptive");
+  int nprotect=0;
+  SEXP gx = PROTECT(growwise(x)); nprotect++;
+  SEXP gn = n;
+  if (LOGICAL(adaptive)[0]) {
+    if (length(n) != length(x))
+      error(_("length of integer vector(s) provided as list to 'n' argument must be equal to number of observations provided in 'x'"));
+    gn = PROTECT(growwise(n)); nprotect++;
+  }
+  SEXP grp = PROTECT(allocVector(VECSXP, 2)); nprotect++;
+  SET_VECTOR_ELT(grp, 0, allocVector(INTSXP, ngrp));
+  SET_VECTOR_ELT(grp, 1, allocVector(INTSXP, ngrp));
+  int *gs = INTEGER(VECTOR_ELT(grp, 0)), *gl = INTEGER(VECTOR_ELT(grp, 1));
+  for (int i=0, cum=0; i<ngrp; ++i) { gs[i] = cum; gl[i] = grpsize[i]; cum += grpsize[i]; }
+  SEXP ans = frollfunR(fun, gx, gn, fill, algo, align, narm, hasnf, adaptive, p, grp);
+  UNPROTECT(nprotect);
+  return ans;
+}
+
+SEXP gfcum(SEXP fun, SEXP x, SEXP narm) {
+  if (!isLogical(x) && !isInteger(x) && !isReal(x))
+    error(_("Type '%s' is not supported by GForce fcum. Either add the namespace prefix (e.g. data.table::fcumsum(.)) or turn off GForce optimization using options(datatable.optimize=1)"), type2char(TYPEOF(x)));
+  SEXP gx = PROTECT(growwise(x));
+  SEXP starts = PROTECT(allocVector(INTSXP, ngrp));
+  int *is = INTEGER(starts);
+  for (int i=0, cum=0; i<ngrp; ++i) { is[i] = cum+1; cum += grpsize[i]; }
+  SEXP ans = fcumR(fun, gx, narm, R_NilValue, starts);
+  UNPROTECT(2);
+  return ans;
+}
+
+// nafill(x, "locf") etc by group: x is gathered into group order once by growwise() and nafillR() then carries within the
+// groups, which are contiguous now, in its parallel chunked pass; as nafill(x, type, by=g) does but without the ordering
+SEXP gnafill(SEXP x, SEXP type, SEXP fill, SEXP nan_is_na) {
+  if (!isLogical(x) && !isInteger(x) && !isReal(x) && !isString(x))
+    error(_("Type '%s' is not supported by GForce nafill. Either add the namespace prefix (e.g. data.table::nafill(.)) or turn off GForce optimization using options(datatable.optimize=1)"), type2char(TYPEOF(x)));
+  SEXP gx = PROTECT(growwise(x));
+  SEXP starts = PROTECT(allocVector(INTSXP, ngrp));
+  int *is = INTEGER(starts);
+  for (int i=0, cum=0; i<ngrp; ++i) { is[i] = cum+1; cum += grpsize[i]; }
+  SEXP ans = nafillR(gx, type, fill, nan_is_na, ScalarLogical(FALSE), R_NilValue, R_NilValue, starts);
+  UNPROTECT(2);
+  return ans;
+}
@@ -0,0 +1,94 @@
+#include "data.table.h"
+
+/* hash table keyed by SEXP address, mainly of CHARSXP in R's global cache, as an alternative to marking them via TRUELENGTH
+ *   open addressing with linear probing in a power of 2 table, never more than half full
+ *   memory is R_alloc'd so nothing needs to be released when an error happens while the table is in use, unlike savetl
+ *   hash_set is single threaded; once the table is built, hash_lookup may be called from many threads at once
+ */
+
+struct hash_pair {
+  SEXP key;     // NULL for an empty slot since no valid SEXP is a null pointer
+  R_xlen_t value;
+};
+
+struct hash_tab {
+  size_t size, free; // number of slots (a power of 2), and number of keys that can be set before growing
+  int shift;         // 64 - log2(size), to keep the high bits of the multiplicative hash
+  struct hash_pair *tb;
+};
+
+static inline size_t hash_index(SEXP key, int shift) {
+  // Fibonacci hashing; the low bits of addresses are the same due to alignment but the multiplication moves entropy to the high bits
+  return (size_t)(((uint64_t)(uintptr_t)key * 0x9E3779B97F4A7C15ULL) >> shift);
+}
+
+static struct hash_pair *hash_alloc(size_t size) {
+  struct hash_pair *tb = (struct hash_pair *)R_alloc(size, sizeof(*tb));
+  for (size_t i=0; i<size; i++) tb[i] = (struct hash_pair){ .key=NULL, .value=0 };
+  return tb;
+}
+
+// n is the expected number of keys; the table grows when more are set
+hashtab *hash_create(size_t n) {
+  size_t size = 16;
+  int shift = 60;
+  while (size/2 < n) {
+    if (size > SIZE_MAX/4 || shift==0)
+      internal_error(__func__, "hash table of %zu keys is too large", n); // # nocov
+    size *= 2;
+    shift--;
+  }
+  hashtab *h = (hashtab *)R_alloc(1, sizeof(*h));
+  *h = (hashtab){ .size=size, .free=size/2, .shift=shift, .tb=hash_alloc(size) };
+  return h;
+}
+
+static void hash_grow(hashtab *h) {
+  if (h->size > SIZE_MAX/4 || h->shift==0)
+    internal_error(__func__, "hash table of %zu slots cannot grow", h->size); // # nocov
+  const size_t size = h->size*2, mask = size-1;
+  const int shift = h->shift-1;
+  struct hash_pair *tb = hash_alloc(size); // the old table is released by R when .Call returns
+  for (size_t i=0; i<h->size; i++) {
+    const SEXP key = h->tb[i].key;
+    if (!key) continue;
+    size_t j = hash_index(key, shift);
+    while (tb[j].key) j = (j+1) & mask;
+    tb[j] = h->tb[i];
+  }
+  h->free += h->size/2;
+  h->size = size;
+  h->shift = shift;
+  h->tb = tb;
+}
+
+// sets the value of key, inserting key when it is not in the table
+void hash_set(hashtab *h, SEXP key, R_xlen_t value) {
+  const size_t mask = h->size-1;
+  size_t i = hash_index(key, h->shift);
+  while (h->tb[i].key) {
+    if (h->tb[i].key == key) {
+      h->tb[i].value = value;
+      return;
+    }
+    i = (i+1) & mask;
+  }
+  if (!h->free) {
+    hash_grow(h);
+    hash_set(h, key, value);
+    return;
+  }
+  h->tb[i] = (struct hash_pair){ .key=key, .value=value };
+  h->free--;
+}
+
+// value of key, or ifnotfound; read only so thread safe
+R_xlen_t hash_lookup(const hashtab *h, SEXP key, R_xlen_t ifnotfound) {
+  const size_t mask = h->size-1;
+  size_t i = hash_index(key, h->shift);
+  while (h->tb[i].key) {
+    if (h->tb[i].key == key) return h->tb[i].value;
+    i = (i+1) & mask;
+  }
+  return ifnotfound;
+}
@@ -730,3 +730,305 @@ SEXP overlaps(SEXP ux, SEXP imatches, SEXP multArg, SEXP typeArg, SEXP nomatchAr
   UNPROTECT(1);
   return(ans);
 }
+
+// Interval index for foverlaps type="any" and "within", used instead of lookup() + overlaps() above. Those materialise, for
+// every unique endpoint of y, the list of y rows covering it; with heavily overlapping ranges that is O(nrow(y)^2) memory.
+// Here y (sorted by its key: by-columns, start, end) gets a max-tree over its end column: leaf r holds end[r] and every
+// internal node the max of its children. For each x row we binary search its y group for the last start <= A and then
+// descend the tree over that prefix, pruning any subtree whose max end is < B. That visits O((k+1)log n) nodes for k
+// matches, in y row order, and the only allocation is the tree itself (2 doubles per row of y).
+//   type="any":    y.start <= x.end   && y.end >= x.start   i.e. A=x.end,   B=x.start
+//   type="within": y.start <= x.start && y.end >= x.end     i.e. A=x.start, B=x.end
+// Probing is parallel over x rows in two passes (count, then fill at cumulative offsets) so the output is written directly
+// into the xid/yid vectors in the same order as overlaps() returns them. nqIntervalIndex() below probes the same index for
+// non-equi joins of the form on=.(start<=A, end>=B).
+
+typedef struct { int node, lo, hi; } itnode_t;
+
+static double *itree_build(const double *yend, const int ny, int *mp)
+{
+  // m leaves, a power of 2 >= ny; padding leaves are -Inf so never match
+  int m = 1;
+  while (m < ny) m <<= 1;
+  double *tree = (double *)R_alloc(2*(size_t)m, sizeof(double));
+  #pragma omp parallel for num_threads(getDTthreads(m, true))
+  for (int r=0; r<m; ++r) tree[m+r] = r<ny ? yend[r] : R_NegInf;
+  for (int node=m-1; node>=1; --node) tree[node] = tree[2*node]>tree[2*node+1] ? tree[2*node] : tree[2*node+1];
+  *mp = m;
+  return tree;
+}
+
+static int itree_probe(const double *tree, const int m, const int qlo, const int qhi, const double b, const bool bstrict, const bool rev, const bool one, int *out)
+{
+  // leaves [qlo,qhi) with tree value >= b (> b when bstrict), ascending (or descending when rev); stops at the first one found when one
+  itnode_t stack[2*32+2];
+  int top=0, k=0;
+  stack[top++] = (itnode_t){1, 0, m};
+  while (top) {
+    const itnode_t s = stack[--top];
+    if (s.hi<=qlo || s.lo>=qhi || tree[s.node]<b || (bstrict && tree[s.node]==b)) continue;
+    if (s.hi-s.lo==1) {
+      if (out) out[k] = s.lo+1;
+      k++;
+      if (one) break;
+      continue;
+    }
+    const int mid = s.lo + (s.hi-s.lo)/2;
+    const itnode_t l = {2*s.node, s.lo, mid}, r = {2*s.node+1, mid, s.hi};
+    if (rev) { stack[top++]=l; stack[top++]=r; } else { stack[top++]=r; stack[top++]=l; }
+  }
+  return k;
+}
+
+SEXP overlapsIndex(SEXP ystartArg, SEXP yendArg, SEXP loArg, SEXP lenArg, SEXP xstartArg, SEXP xendArg, SEXP multArg, SEXP typeArg, SEXP nomatchArg, SEXP verboseArg)
+{
+  const bool verbose = LOGICAL(verboseArg)[0];
+  const int ny=length(ystartArg), nx=length(xstartArg), nomatch=INTEGER(nomatchArg)[0];
+  if (length(yendArg)!=ny || length(xendArg)!=nx)
+    internal_error(__func__, "start and end columns are not the same length"); // # nocov
+  if (!isNull(loArg) && (length(loArg)!=nx || length(lenArg)!=nx))
+    internal_error(__func__, "lo and len must be NULL or length nrow(x)"); // # nocov
+  enum {ALL, FIRST, LAST} mult = ALL;
+  if (!strcmp(CHAR(STRING_ELT(multArg, 0)), "all"))  mult = ALL;
+  else if (!strcmp(CHAR(STRING_ELT(multArg, 0)), "first")) mult = FIRST;
+  else if (!strcmp(CHAR(STRING_ELT(multArg, 0)), "last")) mult = LAST;
+  else internal_error(__func__, "invalid value for 'mult'; this should have been caught before"); // # nocov
+  bool within = false;
+  if (!strcmp(CHAR(STRING_ELT(typeArg, 0)), "within")) within = true;
+  else if (strcmp(CHAR(STRING_ELT(typeArg, 0)), "any")) internal_error(__func__, "type must be 'any' or 'within'"); // # nocov
+
+  int nprotect=0;
+  const double *ystart = REAL(PROTECT(coerceVector(ystartArg, REALSXP))); nprotect++;
+  const double *yend   = REAL(PROTECT(coerceVector(yendArg,   REALSXP))); nprotect++;
+  const double *qa = REAL(PROTECT(coerceVector(within ? xstartArg : xendArg, REALSXP))); nprotect++;
+  const double *qb = REAL(PROTECT(coerceVector(within ? xendArg : xstartArg, REALSXP))); nprotect++;
+  const int *lo  = isNull(loArg) ? NULL : INTEGER(loArg);
+  const int *len = isNull(lenArg) ? NULL : INTEGER(lenArg);
+
+  double tic = verbose ? wallclock() : 0;
+  int m;
+  const double *tree = itree_build(yend, ny, &m);
+  if (verbose) {
+    Rprintf(_("Interval index on %d rows of y built in %.3fs\n"), ny, wallclock()-tic);
+    tic = wallclock();
+  }
+
+  // for each x row the prefix [qlo,qhi) of its y group whose start <= A; qhi==qlo when there is nothing to probe
+  int *qlo = (int *)R_alloc(nx, sizeof(int)), *qhi = (int *)R_alloc(nx, sizeof(int));
+  #pragma omp parallel for num_threads(getDTthreads(nx, true))
+  for (int i=0; i<nx; ++i) {
+    int l=0, u=ny;
+    if (lo) {
+      l = lo[i]>0 ? lo[i]-1 : 0;
+      u = lo[i]>0 ? l+len[i] : 0;
+    }
+    const int start = l;
+    while (l<u) {  // first row in [start,u) with ystart > A
+      const int mid = l + (u-l)/2;
+      if (ystart[mid] <= qa[i]) l=mid+1; else u=mid;
+    }
+    qlo[i] = start; qhi[i] = l;
+  }
+
+  int *cnt = NULL;
+  int64_t totlen = nx;
+  if (mult==ALL) {
+    cnt = (int *)R_alloc(nx, sizeof(int));
+    #pragma omp parallel for num_threads(getDTthreads(nx, true))
+    for (int i=0; i<nx; ++i) {
+      const int k = qlo[i]<qhi[i] ? itree_probe(tree, m, qlo[i], qhi[i], qb[i], false, false, false, NULL) : 0;
+      cnt[i] = k ? k : 1;  // a row of nomatch when there is no overlap, as overlaps() does
+    }
+    totlen = 0;
+    for (int i=0; i<nx; ++i) { const int c=cnt[i]; cnt[i]=(int)totlen; totlen+=c; }  // cnt now holds the offset of each x row
+    if (totlen > INT_MAX)
+      error(_("foverlaps result would have %lld rows which exceeds the maximum of %d"), (long long)totlen, INT_MAX);
+  }
+
+  SEXP ans = PROTECT(allocVector(VECSXP, 2)); nprotect++;
+  SET_VECTOR_ELT(ans, 0, allocVector(INTSXP, totlen));
+  SET_VECTOR_ELT(ans, 1, allocVector(INTSXP, totlen));
+  int *xid = INTEGER(VECTOR_ELT(ans, 0)), *yid = INTEGER(VECTOR_ELT(ans, 1));
+  #pragma omp parallel for num_threads(getDTthreads(nx, true))
+  for (int i=0; i<nx; ++i) {
+    const int off = cnt ? cnt[i] : i;
+    const int k = qlo[i]<qhi[i] ? itree_probe(tree, m, qlo[i], qhi[i], qb[i], false, mult==LAST, mult!=ALL, yid+off) : 0;
+    if (!k) yid[off] = nomatch;
+    const int n = k ? k : 1;
+    for (int j=0; j<n; ++j) xid[off+j] = i+1;
+  }
+  if (verbose)
+    Rprintf(_("Probing interval index with %d rows of x found %lld rows in %.3fs\n"), nx, (long long)totlen, wallclock()-tic);
+  UNPROTECT(nprotect);
+  return ans;
+}
+
+// Non-equi join on=.(..., start<=A, end>=B) (or < and >) of i to x, called from bmerge() in place of the nested group ids
+// when x is large. x is ordered by its equi join columns then start (xo); lo/len are the range of each i row's equi join
+// group in that order, or NULL when there are none. Each i row's matches are found as in overlapsIndex() and returned in
+// the form Cbmerge() returns: for mult="all" one (starts, lens, indices) entry per run of consecutive positions of xo,
+// the entries of each i row together and in i order; for "first"/"last" the match whose row of x is smallest/largest.
+static int itree_runs(const double *tree, const int m, const int qlo, const int qhi, const double b, const bool bstrict, int *starts, int *lens)
+{
+  // like itree_probe ascending, but counts (and writes when starts) runs of consecutive leaves as 1-based start and length
+  itnode_t stack[2*32+2];
+  int top=0, k=0, prev=-2;
+  stack[top++] = (itnode_t){1, 0, m};
+  while (top) {
+    const itnode_t s = stack[--top];
+    if (s.hi<=qlo || s.lo>=qhi || tree[s.node]<b || (bstrict && tree[s.node]==b)) continue;
+    if (s.hi-s.lo==1) {
+      if (s.lo==prev+1) {
+        if (starts) lens[k-1]++;
+      } else {
+        if (starts) { starts[k] = s.lo+1; lens[k] = 1; }
+        k++;
+      }
+      prev = s.lo;
+      continue;
+    }
+    const int mid = s.lo + (s.hi-s.lo)/2;
+    stack[top++] = (itnode_t){2*s.node+1, mid, s.hi};
+    stack[top++] = (itnode_t){2*s.node, s.lo, mid};
+  }
+  return k;
+}
+
+static int itree_extreme(const double *tree, const int m, const int qlo, const int qhi, const double b, const bool bstrict, const int *xo, const bool last)
+{
+  // the 1-based leaf among those matching whose row of x (xo[leaf]) is smallest (largest when last); 0 when none match
+  itnode_t stack[2*32+2];
+  int top=0, best=0;
+  stack[top++] = (itnode_t){1, 0, m};
+  while (top) {
+    const itnode_t s = stack[--top];
+    if (s.hi<=qlo || s.lo>=qhi || tree[s.node]<b || (bstrict && tree[s.node]==b)) continue;
+    if (s.hi-s.lo==1) {
+      const int row = xo ? xo[s.lo] : s.lo+1;
+      if (!best || (last ? row > (xo ? xo[best-1] : best) : row < (xo ? xo[best-1] : best))) best = s.lo+1;
+      continue;
+    }
+    const int mid = s.lo + (s.hi-s.lo)/2;
+    stack[top++] = (itnode_t){2*s.node+1, mid, s.hi};
+    stack[top++] = (itnode_t){2*s.node, s.lo, mid};
+  }
+  return best;
+}
+
+SEXP nqIntervalIndex(SEXP xstartArg, SEXP xendArg, SEXP xoArg, SEXP loArg, SEXP lenArg, SEXP iaArg, SEXP ibArg, SEXP strictArg, SEXP multArg, SEXP nomatchArg)
+{
+  const bool verbose = GetVerbose();
+  const int nx=length(xstartArg), ni=length(iaArg);
+  if (length(xendArg)!=nx || length(ibArg)!=ni || (length(xoArg) && length(xoArg)!=nx))
+    internal_error(__func__, "columns of x or i are not the same length"); // # nocov
+  if (!isNull(loArg) && (length(loArg)!=ni || length(lenArg)!=ni))
+    internal_error(__func__, "lo and len must be NULL or length nrow(i)"); // # nocov
+  if (!isLogical(strictArg) || length(strictArg)!=2)
+    internal_error(__func__, "strict must be a length 2 logical"); // # nocov
+  const bool astrict = LOGICAL(strictArg)[0], bstrict = LOGICAL(strictArg)[1];
+  enum {ALL, FIRST, LAST} mult = ALL;
+  if (!strcmp(CHAR(STRING_ELT(multArg, 0)), "all"))  mult = ALL;
+  else if (!strcmp(CHAR(STRING_ELT(multArg, 0)), "first")) mult = FIRST;
+  else if (!strcmp(CHAR(STRING_ELT(multArg, 0)), "last")) mult = LAST;
+  else internal_error(__func__, "invalid value for 'mult'; this should have been caught before"); // # nocov
+  const int nomatch = isNull(nomatchArg) ? 0 : INTEGER(nomatchArg)[0];
+  const int nomatchlen = nomatch!=0;
+
+  int nprotect=0;
+  const int *xo = length(xoArg) ? INTEGER(xoArg) : NULL;
+  const double *xstart = REAL(PROTECT(coerceVector(xstartArg, REALSXP))); nprotect++;
+  const double *xend   = REAL(PROTECT(coerceVector(xendArg,   REALSXP))); nprotect++;
+  const double *qa = REAL(PROTECT(coerceVector(iaArg, REALSXP))); nprotect++;
+  const double *qb = REAL(PROTECT(coerceVector(ibArg, REALSXP))); nprotect++;
+  const int *lo  = isNull(loArg) ? NULL : INTEGER(loArg);
+  const int *len = isNull(lenArg) ? NULL : INTEGER(lenArg);
+
+  double tic = verbose ? wallclock() : 0;
+  // start and end of x in the order of xo
+  double *ystart = (double *)R_alloc(nx, sizeof(double)), *yend = (double *)R_alloc(nx, sizeof(double));
+  #pragma omp parallel for num_threads(getDTthreads(nx, true))
+  for (int r=0; r<nx; ++r) {
+    const int k = xo ? xo[r]-1 : r;
+    ystart[r] = xstart[k];
+    yend[r] = xend[k];
+  }
+  int m;
+  const double *tree = itree_build(yend, nx, &m);
+
+  // for each i row the prefix [qlo,qhi) of its x group whose start <= A (< A when astrict)
+  int *qlo = (int *)R_alloc(ni, sizeof(int)), *qhi = (int *)R_alloc(ni, sizeof(int));
+  #pragma omp parallel for num_threads(getDTthreads(ni, true))
+  for (int i=0; i<ni; ++i) {
+    int l=0, u=nx;
+    if (lo) {
+      l = lo[i]>0 ? lo[i]-1 : 0;
+      u = lo[i]>0 ? l+len[i] : 0;
+    }
+    const int start = l;
+    while (l<u) {
+      const int mid = l + (u-l)/2;
+      if (astrict ? ystart[mid] < qa[i] : ystart[mid] <= qa[i]) l=mid+1; else u=mid;
+    }
+    qlo[i] = start; qhi[i] = l;
+  }
+
+  SEXP ans = PROTECT(allocVector(VECSXP, 5)); nprotect++;
+  SEXP ansnames = PROTECT(allocVector(STRSXP, 5)); nprotect++;
+  SET_STRING_ELT(ansnames, 0, char_starts);
+  SET_STRING_ELT(ansnames, 1, char_lens);
+  SET_STRING_ELT(ansnames, 2, char_indices);
+  SET_STRING_ELT(ansnames, 3, char_allLen1);
+  SET_STRING_ELT(ansnames, 4, char_allGrp1);
+  setAttrib(ans, R_NamesSymbol, ansnames);
+  bool allLen1 = true, allGrp1 = true;
+  int64_t totlen = ni;
+  if (mult==ALL) {
+    int *off = (int *)R_alloc(ni, sizeof(int));
+    #pragma omp parallel for num_threads(getDTthreads(ni, true))
+    for (int i=0; i<ni; ++i) {
+      const int k = qlo[i]<qhi[i] ? itree_runs(tree, m, qlo[i], qhi[i], qb[i], bstrict, NULL, NULL) : 0;
+      off[i] = k ? k : 1;  // an entry of nomatch when there is no match, as bmerge does
+    }
+    totlen = 0;
+    for (int i=0; i<ni; ++i) {
+      const int c=off[i];
+      if (c>1) allGrp1 = false;
+      off[i]=(int)totlen;
+      totlen+=c;
+    }
+    if (totlen > INT_MAX)
+      error(_("Non-equi join would have %lld matching runs which exceeds the maximum of %d"), (long long)totlen, INT_MAX); // # nocov
+    SET_VECTOR_ELT(ans, 0, allocVector(INTSXP, totlen));
+    SET_VECTOR_ELT(ans, 1, allocVector(INTSXP, totlen));
+    SET_VECTOR_ELT(ans, 2, allocVector(INTSXP, totlen));
+    int *starts = INTEGER(VECTOR_ELT(ans, 0)), *lens = INTEGER(VECTOR_ELT(ans, 1)), *indices = INTEGER(VECTOR_ELT(ans, 2));
+    #pragma omp parallel for num_threads(getDTthreads(ni, true)) reduction(&&:allLen1)
+    for (int i=0; i<ni; ++i) {
+      const int o = off[i];
+      const int k = qlo[i]<qhi[i] ? itree_runs(tree, m, qlo[i], qhi[i], qb[i], bstrict, starts+o, lens+o) : 0;
+      if (!k) { starts[o] = nomatch; lens[o] = nomatchlen; }
+      const int n = k ? k : 1;
+      for (int j=0; j<n; ++j) {
+        indices[o+j] = i+1;
+        if (lens[o+j]>1) allLen1 = false;
+      }
+    }
+  } else {
+    SET_VECTOR_ELT(ans, 0, allocVector(INTSXP, ni));
+    SET_VECTOR_ELT(ans, 1, allocVector(INTSXP, ni));
+    SET_VECTOR_ELT(ans, 2, allocVector(INTSXP, 0));
+    int *starts = INTEGER(VECTOR_ELT(ans, 0)), *lens = INTEGER(VECTOR_ELT(ans, 1));
+    #pragma omp parallel for num_threads(getDTthreads(ni, true))
+    for (int i=0; i<ni; ++i) {
+      const int k = qlo[i]<qhi[i] ? itree_extreme(tree, m, qlo[i], qhi[i], qb[i], bstrict, xo, mult==LAST) : 0;
+      starts[i] = k ? k : nomatch;
+      lens[i] = k ? 1 : nomatchlen;
+    }
+  }
+  SET_VECTOR_ELT(ans, 3, ScalarLogical(allLen1));
+  SET_VECTOR_ELT(ans, 4, ScalarLogical(allGrp1));
+  if (verbose)
+    Rprintf(_("  Probing interval index on %d rows of x with %d rows of i found %lld entries in %.3fs\n"), nx, ni, (long long)totlen, wallclock()-tic);
+  UNPROTECT(nprotect);
+  return ans;
+}
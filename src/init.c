@@ -98,6 +98,8 @@ R_CallMethodDef callMethods[] = {
 {"Cdt_na", (DL_FUNC) &dt_na, -1},
 {"Clookup", (DL_FUNC) &lookup, -1},
 {"Coverlaps", (DL_FUNC) &overlaps, -1},
+{"CoverlapsIndex", (DL_FUNC) &overlapsIndex, -1},
+{"CnqIntervalIndex", (DL_FUNC) &nqIntervalIndex, -1},
 {"Cwhichwrapper", (DL_FUNC) &whichwrapper, -1},
 {"Cshift", (DL_FUNC) &shift, -1},
 {"Ctranspose", (DL_FUNC) &transpose, -1},
@@ -117,6 +119,13 @@ R_CallMethodDef callMethods[] = {
 {"Cgsd", (DL_FUNC) &gsd, -1},
 {"Cgprod", (DL_FUNC) &gprod, -1},
 {"Cgshift", (DL_FUNC) &gshift, -1},
+{"Cgrowwise", (DL_FUNC) &growwise, -1},
+{"Cgquantile", (DL_FUNC) &gquantile, -1},
+{"Cgmad", (DL_FUNC) &gmad, -1},
+{"CguniqueN", (DL_FUNC) &guniqueN, -1},
+{"Cgfroll", (DL_FUNC) &gfroll, -1},
+{"Cgfcum", (DL_FUNC) &gfcum, -1},
+{"Cgnafill", (DL_FUNC) &gnafill, -1},
 {"Cnestedid", (DL_FUNC) &nestedid, -1},
 {"CsetDTthreads", (DL_FUNC) &setDTthreads, -1},
 {"CgetDTthreads", (DL_FUNC) &getDTthreads_R, -1},
@@ -127,7 +136,11 @@ R_CallMethodDef callMethods[] = {
 {"Cbetween", (DL_FUNC) &between, -1},
 {"ChasOpenMP", (DL_FUNC) &hasOpenMP, -1},
 {"CuniqueNlogical", (DL_FUNC) &uniqueNlogical, -1},
+{"CuniqueNapprox", (DL_FUNC) &uniqueNapprox, -1},
+{"Chashuniq", (DL_FUNC) &hashuniq, -1},
 {"CfrollfunR", (DL_FUNC) &frollfunR, -1},
+{"CfcumR", (DL_FUNC) &fcumR, -1},
+{"CfewmR", (DL_FUNC) &fewmR, -1},
 {"CdllVersion", (DL_FUNC) &dllVersion, -1},
 {"CnafillR", (DL_FUNC) &nafillR, -1},
 {"CcolnamesInt", (DL_FUNC) &colnamesInt, -1},
@@ -160,6 +173,7 @@ R_CallMethodDef callMethods[] = {
 {"CmemcpyDTadaptive", (DL_FUNC)&memcpyDTadaptive, -1},
 {"Csetgrowable", (DL_FUNC)&setgrowable, -1},
 {"Cfrolladapt", (DL_FUNC)&frolladapt, -1},
+{"Cfrollindex", (DL_FUNC)&frollindex, -1},
 {NULL, NULL, 0}
 };
 
@@ -1,98 +1,180 @@
 #include "data.table.h"
 
-void nafillDouble(double *x, uint_fast64_t nx, unsigned int type, double fill, bool nan_is_na, ans_t *ans, bool verbose) {
+/* const replaces missing values by fill, in parallel over nc chunks of x
+ * locf (nocb) carries the last (next) observed value forward (backward) along the scan order, which is o (1-based) when
+ * given and x as it is otherwise; gs are 0-based positions in the scan order where groups start, or NULL for a single group.
+ * Missing values before the first (after the last) observation of a group are replaced by fill. The scan order is cut into
+ * nc chunks and filled in three phases, like fcumfun in fcum.c
+ *   1) each chunk carries its own observations, leaving its missing values before (after, for nocb) its first observation
+ *      or group boundary for later, in parallel
+ *   2) the carry into each chunk is the last carried value of the preceding chunk (following chunk, for nocb), or the carry
+ *      into that chunk when it had neither observations nor group boundaries, sequentially over chunks
+ *   3) each chunk fills the missing values left in phase 1 by its carry, in parallel
+ * so parallelism does not depend on number or sizes of groups, and a single long column uses all threads
+ * MISS(v) tells if value v is missing, SET(i, v) writes v to the answer at i
+ */
+#define NAFILL(CTYPE, X, MISS, SET) do {                                                                    \
+  const int64_t n = nx;                                                                                     \
+  if (type==0) {                                                                                            \
+    _Pragma("omp parallel for num_threads(nc)")                                                             \
+    for (int64_t i=0; i<n; i++) {                                                                           \
+      SET(i, MISS(X[i]) ? fill : X[i]);                                                                     \
+    }                                                                                                       \
+    break;                                                                                                  \
+  }                                                                                                         \
+  const bool locf = type==1;                                                                                \
+  CTYPE *tail = malloc(sizeof(*tail) * nc), *carry = malloc(sizeof(*carry) * nc);                           \
+  bool *known = malloc(sizeof(*known) * nc);                                                                \
+  int64_t *lo = malloc(sizeof(*lo) * nc), *hi = malloc(sizeof(*hi) * nc);                                  \
+  if (!tail || !carry || !known || !lo || !hi) { /* # nocov start */                                       \
+    free(tail); free(carry); free(known); free(lo); free(hi);                                               \
+    ansSetMsg(ans, 3, "%s: Unable to allocate memory for chunks", __func__);                                \
+    return;                                                                                                 \
+  } /* # nocov end */                                                                                       \
+  _Pragma("omp parallel for num_threads(nc)")                                                               \
+  for (int c=0; c<nc; c++) {                                                                                \
+    const int64_t from = n*c/nc, to = n*(c+1)/nc;                                                           \
+    CTYPE v = fill;                                                                                         \
+    known[c] = false;                                                                                       \
+    if (locf) {                                                                                             \
+      int g = gs ? firststart(gs, ngrp, from) : 0; /* first group start >= from */                          \
+      lo[c] = from; hi[c] = to;                                                                             \
+      for (int64_t p=from; p<to; p++) {                                                                     \
+        bool start = p==0;                                                                                  \
+        if (gs && g<ngrp && gs[g]==p) {                                                                     \
+          start = true;                                                                                     \
+          g++;                                                                                              \
+        }                                                                                                   \
+        if (start)                                                                                          \
+          v = fill;                                                                                         \
+        const int64_t i = o ? o[p]-1 : p;                                                                   \
+        const CTYPE xi = X[i];                                                                              \
+        if (!MISS(xi))                                                                                      \
+          v = xi;                                                                                           \
+        else if (!start && !known[c])                                                                       \
+          continue;                                                                                         \
+        if (!known[c]) {                                                                                    \
+          known[c] = true;                                                                                  \
+          hi[c] = p; /* [from, p) is left for the carry */                                                  \
+        }                                                                                                   \
+        SET(i, v);                                                                                          \
+      }                                                                                                     \
+    } else {                                                                                                \
+      int g = gs ? firststart(gs, ngrp, to) : 0; /* first group start >= p+1 */                             \
+      lo[c] = from; hi[c] = to;                                                                             \
+      for (int64_t p=to-1; p>=from; p--) {                                                                  \
+        const bool last = p==n-1 || (gs && g<ngrp && gs[g]==p+1);                                            \
+        if (gs && g>0 && gs[g-1]==p)                                                                        \
+          g--;                                                                                              \
+        if (last)                                                                                           \
+          v = fill;                                                                                         \
+        const int64_t i = o ? o[p]-1 : p;                                                                   \
+        const CTYPE xi = X[i];                                                                              \
+        if (!MISS(xi))                                                                                      \
+          v = xi;                                                                                           \
+        else if (!last && !known[c])                                                                        \
+          continue;                                                                                         \
+        if (!known[c]) {                                                                                    \
+          known[c] = true;                                                                                  \
+          lo[c] = p+1; /* [p+1, to) is left for the carry */                                                \
+        }                                                                                                   \
+        SET(i, v);                                                                                          \
+      }                                                                                                     \
+    }                                                                                                       \
+    tail[c] = v;                                                                                            \
+  }                                                                                                         \
+  if (locf) {                                                                                               \
+    carry[0] = fill;                                                                                        \
+    for (int c=1; c<nc; c++)                                                                                \
+      carry[c] = known[c-1] ? tail[c-1] : carry[c-1];                                                       \
+  } else {                                                                                                  \
+    carry[nc-1] = fill;                                                                                     \
+    for (int c=nc-2; c>=0; c--)                                                                             \
+      carry[c] = known[c+1] ? tail[c+1] : carry[c+1];                                                       \
+  }                                                                                                         \
+  _Pragma("omp parallel for num_threads(nc)")                                                               \
+  for (int c=0; c<nc; c++) {                                                                                \
+    const int64_t from = locf ? n*c/nc : lo[c], to = locf ? hi[c] : n*(c+1)/nc;                             \
+    for (int64_t p=from; p<to; p++)                                                                         \
+      SET(o ? o[p]-1 : p, carry[c]);                                                                        \
+  }                                                                                                         \
+  free(tail); free(carry); free(known); free(lo); free(hi);                                                 \
+} while(0)
+
+#define NAFILL_SETV(i, v) ansv[i] = (v)
+#define NAFILL_ISNA_INT(v) ((v)==NA_INTEGER)
+#define NAFILL_ISNA_INT64(v) ((v)==NA_INTEGER64)
+
+static void nafillMsg(ans_t *ans, const char *func, uint_fast64_t nx, unsigned int type, const int *gs, int ngrp, int nc) {
+  if (type!=0)
+    snprintf(end(ans->message[0]), 500, _("%s: filling %"PRIu64" observations in %d group(s), in %d chunk(s)\n"), func, (uint64_t)nx, gs ? ngrp : 1, nc);
+  else
+    snprintf(end(ans->message[0]), 500, _("%s: filling %"PRIu64" observations in %d chunk(s)\n"), func, (uint64_t)nx, nc);
+}
+
+void nafillDouble(double *x, uint_fast64_t nx, unsigned int type, double fill, bool nan_is_na, ans_t *ans, const int *o, const int *gs, int ngrp, int nc, bool verbose) {
   double tic=0.0;
-  if (verbose)
+  if (verbose) {
     tic = omp_get_wtime();
-  if (type==0) { // const
-    if (nan_is_na) {
-      for (uint_fast64_t i=0; i<nx; i++) {
-        ans->dbl_v[i] = ISNAN(x[i]) ? fill : x[i];
-      }
-    } else {
-      for (uint_fast64_t i=0; i<nx; i++) {
-        ans->dbl_v[i] = ISNA(x[i]) ? fill : x[i];
-      }
-    }
-  } else if (type==1) { // locf
-    if (nan_is_na) {
-      ans->dbl_v[0] = ISNAN(x[0]) ? fill : x[0];
-      for (uint_fast64_t i=1; i<nx; i++) {
-        ans->dbl_v[i] = ISNAN(x[i]) ? ans->dbl_v[i-1] : x[i];
-      }
-    } else {
-      ans->dbl_v[0] = ISNA(x[0]) ? fill : x[0];
-      for (uint_fast64_t i=1; i<nx; i++) {
-        ans->dbl_v[i] = ISNA(x[i]) ? ans->dbl_v[i-1] : x[i];
-      }
-    }
-  } else if (type==2) { // nocb
-    if (nan_is_na) {
-      ans->dbl_v[nx-1] = ISNAN(x[nx-1]) ? fill : x[nx-1];
-      for (int_fast64_t i=nx-2; i>=0; i--) {
-        ans->dbl_v[i] = ISNAN(x[i]) ? ans->dbl_v[i+1] : x[i];
-      }
-    } else {
-      ans->dbl_v[nx-1] = ISNA(x[nx-1]) ? fill : x[nx-1];
-      for (int_fast64_t i=nx-2; i>=0; i--) {
-        ans->dbl_v[i] = ISNA(x[i]) ? ans->dbl_v[i+1] : x[i];
-      }
-    }
+    nafillMsg(ans, __func__, nx, type, gs, ngrp, nc);
+  }
+  double *ansv = ans->dbl_v; // not restrict, x is ansv when in place
+  if (nan_is_na) {
+    NAFILL(double, x, ISNAN, NAFILL_SETV);
+  } else {
+    NAFILL(double, x, ISNA, NAFILL_SETV);
   }
   if (verbose)
-    snprintf(ans->message[0], 500, _("%s: took %.3fs\n"), __func__, omp_get_wtime()-tic);
+    snprintf(end(ans->message[0]), 500, _("%s: took %.3fs\n"), __func__, omp_get_wtime()-tic);
 }
-void nafillInteger(int32_t *x, uint_fast64_t nx, unsigned int type, int32_t fill, ans_t *ans, bool verbose) {
+void nafillInteger(int32_t *x, uint_fast64_t nx, unsigned int type, int32_t fill, ans_t *ans, const int *o, const int *gs, int ngrp, int nc, bool verbose) {
   double tic=0.0;
-  if (verbose)
+  if (verbose) {
     tic = omp_get_wtime();
-  if (type==0) { // const
-    for (uint_fast64_t i=0; i<nx; i++) {
-      ans->int_v[i] = x[i]==NA_INTEGER ? fill : x[i];
-    }
-  } else if (type==1) { // locf
-    ans->int_v[0] = x[0]==NA_INTEGER ? fill : x[0];
-    for (uint_fast64_t i=1; i<nx; i++) {
-      ans->int_v[i] = x[i]==NA_INTEGER ? ans->int_v[i-1] : x[i];
-    }
-  } else if (type==2) { // nocb
-    ans->int_v[nx-1] = x[nx-1]==NA_INTEGER ? fill : x[nx-1];
-    for (int_fast64_t i=nx-2; i>=0; i--) {
-      ans->int_v[i] = x[i]==NA_INTEGER ? ans->int_v[i+1] : x[i];
-    }
+    nafillMsg(ans, __func__, nx, type, gs, ngrp, nc);
   }
+  int32_t *ansv = ans->int_v;
+  NAFILL(int32_t, x, NAFILL_ISNA_INT, NAFILL_SETV);
   if (verbose)
-    snprintf(ans->message[0], 500, _("%s: took %.3fs\n"), __func__, omp_get_wtime()-tic);
+    snprintf(end(ans->message[0]), 500, _("%s: took %.3fs\n"), __func__, omp_get_wtime()-tic);
 }
-void nafillInteger64(int64_t *x, uint_fast64_t nx, unsigned int type, int64_t fill, ans_t *ans, bool verbose) {
+void nafillInteger64(int64_t *x, uint_fast64_t nx, unsigned int type, int64_t fill, ans_t *ans, const int *o, const int *gs, int ngrp, int nc, bool verbose) {
   double tic=0.0;
+  if (verbose) {
+    tic = omp_get_wtime();
+    nafillMsg(ans, __func__, nx, type, gs, ngrp, nc);
+  }
+  int64_t *ansv = ans->int64_v;
+  NAFILL(int64_t, x, NAFILL_ISNA_INT64, NAFILL_SETV);
   if (verbose)
+    snprintf(end(ans->message[0]), 500, _("%s: took %.3fs\n"), __func__, omp_get_wtime()-tic);
+}
+// SET_STRING_ELT is not thread safe, so character is filled in a single chunk on the calling thread
+#define NAFILL_SETS(i, v) SET_STRING_ELT(ansx, i, v)
+#define NAFILL_ISNA_STRING(v) ((v)==NA_STRING)
+void nafillString(SEXP x, unsigned int type, SEXP fill, SEXP ansx, ans_t *ans, const int *o, const int *gs, int ngrp, bool verbose) {
+  double tic=0.0;
+  const uint_fast64_t nx = xlength(x);
+  int nc = 1;
+  if (verbose) {
     tic = omp_get_wtime();
-  if (type==0) { // const
-    for (uint_fast64_t i=0; i<nx; i++) {
-      ans->int64_v[i] = x[i]==NA_INTEGER64 ? fill : x[i];
-    }
-  } else if (type==1) { // locf
-    ans->int64_v[0] = x[0]==NA_INTEGER64 ? fill : x[0];
-    for (uint_fast64_t i=1; i<nx; i++) {
-      ans->int64_v[i] = x[i]==NA_INTEGER64 ? ans->int64_v[i-1] : x[i];
-    }
-  } else if (type==2) { // nocb
-    ans->int64_v[nx-1] = x[nx-1]==NA_INTEGER64 ? fill : x[nx-1];
-    for (int_fast64_t i=nx-2; i>=0; i--) {
-      ans->int64_v[i] = x[i]==NA_INTEGER64 ? ans->int64_v[i+1] : x[i];
-    }
+    nafillMsg(ans, __func__, nx, type, gs, ngrp, nc);
   }
+  const SEXP *xp = STRING_PTR_RO(x);
+  NAFILL(SEXP, xp, NAFILL_ISNA_STRING, NAFILL_SETS);
   if (verbose)
-    snprintf(ans->message[0], 500, _("%s: took %.3fs\n"), __func__, omp_get_wtime()-tic);
+    snprintf(end(ans->message[0]), 500, _("%s: took %.3fs\n"), __func__, omp_get_wtime()-tic);
 }
 
 /*
   OpenMP is being used here to parallelize the loop that fills missing values
-    over columns of the input data. This includes handling different data types
-    and applying the designated filling method to each column in parallel.
+    over columns of the input data when there are many columns, otherwise
+    columns are filled one after another, each in parallel over chunks of rows.
+    Character columns are filled on the calling thread.
+  o is the order of groups from forderv, integer() when already grouped, or NULL; starts are 1-based starts of groups in o, or NULL
 */
-SEXP nafillR(SEXP obj, SEXP type, SEXP fill, SEXP nan_is_na_arg, SEXP inplace, SEXP cols) {
+#define NAFILL_TYPE_OK(x) (isReal(x) || isInteger(x) || isLogical(x) || isFactor(x) || isString(x))
+SEXP nafillR(SEXP obj, SEXP type, SEXP fill, SEXP nan_is_na_arg, SEXP inplace, SEXP cols, SEXP o, SEXP starts) {
   int protecti=0;
   const bool verbose = GetVerbose();
 
@@ -113,8 +195,8 @@ SEXP nafillR(SEXP obj, SEXP type, SEXP fill, SEXP nan_is_na_arg, SEXP inplace, S
   if (obj_scalar) {
     if (binplace)
       error(_("'x' argument is atomic vector, in-place update is supported only for list/data.table"));
-    else if (!isReal(obj) && !isInteger(obj))
-      error(_("'x' argument must be numeric type, or list/data.table of numeric types"));
+    else if (!NAFILL_TYPE_OK(obj))
+      error(_("'x' argument must be numeric, logical, character or factor type, or list/data.table of such types"));
     SEXP obj1 = obj;
     obj = PROTECT(allocVector(VECSXP, 1)); protecti++; // wrap into list
     SET_VECTOR_ELT(obj, 0, obj1);
@@ -124,8 +206,8 @@ SEXP nafillR(SEXP obj, SEXP type, SEXP fill, SEXP nan_is_na_arg, SEXP inplace, S
   int *icols = INTEGER(ricols);
   for (int i=0; i<length(ricols); i++) {
     SEXP this_col = VECTOR_ELT(obj, icols[i]-1);
-    if (!isReal(this_col) && !isInteger(this_col))
-      error(_("'x' argument must be numeric type, or list/data.table of numeric types"));
+    if (!NAFILL_TYPE_OK(this_col))
+      error(_("'x' argument must be numeric, logical, character or factor type, or list/data.table of such types"));
     SET_VECTOR_ELT(x, i, this_col);
   }
   R_len_t nx = length(x);
@@ -144,8 +226,12 @@ SEXP nafillR(SEXP obj, SEXP type, SEXP fill, SEXP nan_is_na_arg, SEXP inplace, S
       dx[i] = REAL(xi);
       i64x[i] = (int64_t *)REAL(xi);
       ix[i] = NULL;
+    } else if (isString(xi)) {
+      ix[i] = NULL;
+      dx[i] = NULL;
+      i64x[i] = NULL;
     } else {
-      ix[i] = INTEGER(xi);
+      ix[i] = INTEGER(xi); // also logical and factor
       dx[i] = NULL;
       i64x[i] = NULL;
     }
@@ -155,7 +241,7 @@ SEXP nafillR(SEXP obj, SEXP type, SEXP fill, SEXP nan_is_na_arg, SEXP inplace, S
     for (R_len_t i=0; i<nx; i++) {
       SET_VECTOR_ELT(ans, i, allocVector(TYPEOF(VECTOR_ELT(x, i)), inx[i]));
       const SEXP ansi = VECTOR_ELT(ans, i);
-      const void *p = isReal(ansi) ? (void *)REAL(ansi) : (void *)INTEGER(ansi);
+      const void *p = isReal(ansi) ? (void *)REAL(ansi) : isString(ansi) ? NULL : (void *)INTEGER(ansi);
       vans[i] = ((ans_t) { .dbl_v=(double *)p, .int_v=(int *)p, .int64_v=(int64_t *)p, .status=0, .message={"\0","\0","\0","\0"} });
     }
   } else {
@@ -174,6 +260,22 @@ SEXP nafillR(SEXP obj, SEXP type, SEXP fill, SEXP nan_is_na_arg, SEXP inplace, S
   else
     internal_error(__func__, "invalid %s argument in %s function should have been caught earlier", "type", "nafillR"); // # nocov
 
+  const int *io = NULL, *gs = NULL;
+  int ngrp = 0;
+  if (itype!=0 && !isNull(starts)) { // groups do not matter to const
+    if (!isNull(o) && length(o))
+      io = INTEGER_RO(o);
+    ngrp = length(starts);
+    const int *is = INTEGER_RO(starts);
+    int *igs = (int *)R_alloc(ngrp, sizeof(*igs));
+    for (int g=0; g<ngrp; g++) igs[g] = is[g]-1;
+    gs = igs;
+    for (R_len_t i=0; i<nx; i++) {
+      if (io && (int64_t)inx[i]!=length(o))
+        internal_error(__func__, "length of order %d does not match length of column %d, %"PRId64, length(o), i+1, (int64_t)inx[i]); // # nocov
+    }
+  }
+
   bool hasFill = !isLogical(fill) || LOGICAL(fill)[0]!=NA_LOGICAL;
   bool *isInt64 = (bool *)R_alloc(nx, sizeof(*isInt64));
   for (R_len_t i=0; i<nx; i++)
@@ -200,27 +302,45 @@ SEXP nafillR(SEXP obj, SEXP type, SEXP fill, SEXP nan_is_na_arg, SEXP inplace, S
       fillp[i] = SEXPPTR_RO(VECTOR_ELT(fill, i)); // do like this so we can use in parallel region
     }
   }
-  #pragma omp parallel for if (nx>1) num_threads(getDTthreads(nx, true))
+  // many columns are filled in parallel, one thread each; otherwise each column is filled in parallel over chunks of its rows
+  int nthcol = getDTthreads(nx, true);
+  #pragma omp parallel for if (nthcol>1) num_threads(nthcol)
   for (R_len_t i=0; i<nx; i++) {
+    int nc = nthcol>1 ? 1 : getDTthreads(inx[i], true);
     switch (TYPEOF(VECTOR_ELT(x, i))) {
     case REALSXP : {
       if (isInt64[i]) {
-        nafillInteger64(i64x[i], inx[i], itype, hasFill ? ((int64_t *)fillp[i])[0] : NA_INTEGER64, &vans[i], verbose);
+        nafillInteger64(i64x[i], inx[i], itype, hasFill ? ((int64_t *)fillp[i])[0] : NA_INTEGER64, &vans[i], io, gs, ngrp, nc, verbose);
       } else {
-        nafillDouble(dx[i], inx[i], itype, hasFill ? ((double *)fillp[i])[0] : NA_REAL, nan_is_na, &vans[i], verbose);
+        nafillDouble(dx[i], inx[i], itype, hasFill ? ((double *)fillp[i])[0] : NA_REAL, nan_is_na, &vans[i], io, gs, ngrp, nc, verbose);
       }
     } break;
-    case INTSXP : {
-      nafillInteger(ix[i], inx[i], itype, hasFill ? ((int32_t *)fillp[i])[0] : NA_INTEGER, &vans[i], verbose);
+    case INTSXP : case LGLSXP : {
+      nafillInteger(ix[i], inx[i], itype, hasFill ? ((int32_t *)fillp[i])[0] : NA_INTEGER, &vans[i], io, gs, ngrp, nc, verbose);
     } break;
     }
   }
+  for (R_len_t i=0; i<nx; i++) {
+    SEXP xi = VECTOR_ELT(x, i);
+    if (isString(xi))
+      nafillString(xi, itype, hasFill ? STRING_ELT(VECTOR_ELT(fill, i), 0) : NA_STRING, binplace ? xi : VECTOR_ELT(ans, i), &vans[i], io, gs, ngrp, verbose);
+  }
 
   if (!binplace) {
     for (R_len_t i=0; i<nx; i++) {
       if (!isNull(ATTRIB(VECTOR_ELT(x, i))))
         copyMostAttrib(VECTOR_ELT(x, i), VECTOR_ELT(ans, i));
     }
+  }
+  if (hasFill) {
+    for (R_len_t i=0; i<nx; i++) {
+      // fill not among levels of factor was added as a new level by coerceAs, after the levels of x so codes of x are unchanged
+      SEXP xi = VECTOR_ELT(x, i), filli = VECTOR_ELT(fill, i);
+      if (isFactor(xi) && length(getAttrib(filli, R_LevelsSymbol)) > length(getAttrib(xi, R_LevelsSymbol)))
+        setAttrib(binplace ? xi : VECTOR_ELT(ans, i), R_LevelsSymbol, getAttrib(filli, R_LevelsSymbol));
+    }
+  }
+  if (!binplace) {
     SEXP obj_names = getAttrib(obj, R_NamesSymbol); // copy names
     if (!isNull(obj_names)) {
       SEXP ans_names = PROTECT(allocVector(STRSXP, length(ans))); protecti++;
@@ -71,3 +71,45 @@ double i64quickselect(int64_t *x, int n)
   int64_t a, b;
   BODY(i64swap);
 }
+
+// k'th smallest (0-based) of x[0..n-1], only partitioning x[l..n-1]. Every x[0..l-1] must be <= every x[l..n-1],
+// which holds when l is an order statistic selected by an earlier call on the same x. That way several order statistics
+// of one x (e.g. the lo and hi of several quantiles, taken in increasing order) reuse the partitioning done before them.
+double dquickselectk(double *x, int n, int l, int k)
+{
+  double a;
+  unsigned long ir = n - 1, lo = l;
+  for(;;) {
+    if (ir <= lo + 1) {
+      if (ir == lo + 1 && x[ir] < x[lo]) {
+        dswap(x + lo, x + ir);
+      }
+      break;
+    } else {
+      unsigned long mid = (lo + ir) >> 1;
+      dswap(x + mid, x + lo + 1);
+      if (x[lo] > x[ir]) {
+        dswap(x + lo, x + ir);
+      }
+      if (x[lo + 1] > x[ir]) {
+        dswap(x + lo + 1, x + ir);
+      }
+      if (x[lo] > x[lo + 1]) {
+        dswap(x + lo, x + lo + 1);
+      }
+      unsigned long i = lo + 1, j = ir;
+      a = x[lo + 1];
+      for (;;) {
+        do i++; while (x[i] < a);
+        do j--; while (x[j] > a);
+        if (j < i) break;
+        dswap(x + i, x + j);
+      }
+      x[lo + 1] = x[j];
+      x[j] = a;
+      if (j >= k) ir = j - 1;
+      if (j <= k) lo = i;
+    }
+  }
+  return x[k];
+}
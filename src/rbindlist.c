@@ -2,6 +2,58 @@
 #include <Rdefines.h>
 #include <ctype.h>   // for isdigit
 
+// items are copied into the result in blocks of at most this many rows, so that large items are copied by several threads too
+#define BLOCK_ROWS 65536
+
+// rows of one item of a column whose type needs no coercion, copied after all columns are allocated
+typedef struct {
+  const char *src;
+  char *dst;
+  size_t size;  // bytes
+} copyblock_t;
+
+typedef struct {
+  copyblock_t *b;
+  int64_t n, alloc;
+} copyblocks_t;
+
+// how the codes of one item are written into a factor column of the result
+typedef struct {
+  const int *id;   // codes of a factor item, or NULL
+  const int *map;  // code in the result of each level of a factor item, or NULL when the codes are the same
+  const SEXP *sd;  // strings of a character item, or NULL
+  int val;         // recycled code when id and sd are both NULL; NA when the item has no such column
+  int *dst;        // first row of the item in the result
+} levelmap_t;
+
+typedef struct {
+  int item, from, to;
+} rowblock_t;
+
+static void *colptr(SEXP x) {
+  switch(TYPEOF(x)) {
+  case LGLSXP : return LOGICAL(x);
+  case INTSXP : return INTEGER(x);
+  case REALSXP : return REAL(x);
+  case CPLXSXP : return COMPLEX(x);
+  case RAWSXP : return RAW(x);
+  default : internal_error(__func__, "type '%s' not supported", type2char(TYPEOF(x))); // # nocov
+  }
+}
+
+static void addcopyblocks(copyblocks_t *cb, const void *src, void *dst, int nrow, size_t size) {
+  for (int from=0; from<nrow; from+=BLOCK_ROWS) {
+    if (cb->n==cb->alloc) {
+      cb->alloc = cb->alloc ? 2*cb->alloc : 1024;
+      copyblock_t *tt = (copyblock_t *)R_alloc(cb->alloc, sizeof(*tt));  // the previous ones are released by R when .Call returns
+      if (cb->n) memcpy(tt, cb->b, cb->n*sizeof(*tt));
+      cb->b = tt;
+    }
+    const int n = nrow-from > BLOCK_ROWS ? BLOCK_ROWS : nrow-from;
+    cb->b[cb->n++] = (copyblock_t){ .src=(const char *)src + (size_t)from*size, .dst=(char *)dst + (size_t)from*size, .size=(size_t)n*size };
+  }
+}
+
 SEXP rbindlist(SEXP l, SEXP usenamesArg, SEXP fillArg, SEXP idcolArg, SEXP ignoreattrArg)
 {
   if (!isLogical(fillArg) || LENGTH(fillArg) != 1 || LOGICAL(fillArg)[0] == NA_LOGICAL)
@@ -65,6 +117,11 @@ SEXP rbindlist(SEXP l, SEXP usenamesArg, SEXP fillArg, SEXP idcolArg, SEXP ignor
   if (nrow==0 && ncol==0) return(R_NilValue);
   if (nrow>INT32_MAX) error(_("Total rows in the list is %"PRId64" which is larger than the maximum number of rows, currently %d"), (int64_t)nrow, INT32_MAX);
   if (usenames==TRUE && !anyNames) error(_("use.names=TRUE but no item of input list has any names"));
+  int *itemStart = (int *)R_alloc(LENGTH(l), sizeof(*itemStart));  // row of the result where each item starts, so that items can be copied independently
+  for (int i=0, ansloc=0; i<LENGTH(l); ++i) {
+    itemStart[i] = ansloc;
+    ansloc += eachMax[i];
+  }
 
   int *colMap=NULL; // maps each column in final result to the column of each list item
   if (usenames==TRUE || usenames==NA_LOGICAL) {
@@ -275,6 +332,7 @@ SEXP rbindlist(SEXP l, SEXP usenamesArg, SEXP fillArg, SEXP idcolArg, SEXP ignor
   }
 
   SEXP coercedForFactor = NULL;
+  copyblocks_t copies = { .b=NULL, .n=0, .alloc=0 };
   for(int j=0; j<ncol; ++j) {
     int maxType=LGLSXP;  // initialize with LGLSXP for test 2002.3 which has col x NULL in both lists to be filled with NA for #1871
     bool factor=false, orderedFactor=false;     // ordered factor is class c("ordered","factor"). isFactor() is true when isOrdered() is true.
@@ -348,8 +406,7 @@ SEXP rbindlist(SEXP l, SEXP usenamesArg, SEXP fillArg, SEXP idcolArg, SEXP ignor
 
     if (factor && anyNotStringOrFactor) {
       // in future warn, or use list column instead ... warning(_("Column %d contains a factor but not all items for the column are character or factor"), idcol+j+1);
-      // some coercing from (likely) integer/numeric to character will be needed. But this coerce can feasibly fail with out-of-memory, so we have to do it up-front
-      // before the savetl_init() because we have no hook to clean up tl if coerceVector fails.
+      // some coercing from (likely) integer/numeric to character will be needed, up-front so that the strings are there when the levels are merged.
       if (coercedForFactor==NULL) { coercedForFactor=PROTECT(allocVector(VECSXP, LENGTH(l))); nprotect++; }
       for (int i=0; i<LENGTH(l); ++i) {
         SEXP li = VECTOR_ELT(l, i);
@@ -361,12 +418,22 @@ SEXP rbindlist(SEXP l, SEXP usenamesArg, SEXP fillArg, SEXP idcolArg, SEXP ignor
         }
       }
     }
-    int ansloc=0;
     if (factor) {
       char warnStr[1000] = "";
-      savetl_init();  // no error from now (or warning given options(warn=2)) until savetl_end
+      // The levels are merged in order of first appearance, serially since that's cheap compared to writing the rows. Each level seen so far
+      // maps to its position in the result's levels via a hash table rather than by marking TRUELENGTH, so that there is no global state to
+      // restore when an error happens, and so that the codes of all items can then be written in parallel looking up the table from all threads.
+      size_t nLevelGuess = 1024;
+      for (int i=0; i<LENGTH(l); ++i) {
+        SEXP li = VECTOR_ELT(l, i);
+        int w = usenames ? colMap[i*ncol + j] : (j<length(li) ? j : -1); // check if j exceeds length for fill=TRUE and usenames=FALSE #5444
+        if (w==-1) continue;
+        SEXP thisCol = VECTOR_ELT(li, w);
+        if (isFactor(thisCol)) nLevelGuess += length(getAttrib(thisCol, R_LevelsSymbol));
+      }
+      hashtab *marks = hash_create(nLevelGuess);
       int nLevel=0, allocLevel=0;
-      SEXP *levelsRaw = NULL;  // growing list of SEXP pointers. Raw since managed with raw realloc.
+      SEXP *levelsRaw = NULL;  // growing list of SEXP pointers, on R's heap so that nothing leaks on error
       if (orderedFactor) {
         // If all sets of ordered levels are compatible (no ambiguities or conflicts) then an ordered factor is created, otherwise regular factor.
         // Currently the longest set of ordered levels is taken and all other ordered levels must be a compatible subset of that.
@@ -377,16 +444,11 @@ SEXP rbindlist(SEXP l, SEXP usenamesArg, SEXP fillArg, SEXP idcolArg, SEXP ignor
         //      c( a<c<b, c<b<d<e )  => regular factor because this case isn't yet implemented. a<c<b<d<e would be possible in future (extending longest at the beginning or end)
         const SEXP *sd = STRING_PTR_RO(longestLevels);
         nLevel = allocLevel = longestLen;
-        levelsRaw = malloc(sizeof(*levelsRaw) * nLevel);
-        if (!levelsRaw) {
-          savetl_end(); // # nocov
-          error(_("Failed to allocate working memory for %d ordered factor levels of result column %d"), nLevel, idcol+j+1); // # nocov
-        }
+        levelsRaw = (SEXP *)R_alloc(allocLevel, sizeof(*levelsRaw));
         for (int k=0; k<longestLen; ++k) {
           SEXP s = sd[k];
-          if (TRUELENGTH(s)>0) savetl(s);
           levelsRaw[k] = s;
-          SET_TRUELENGTH(s,-k-1);
+          hash_set(marks, s, k+1);
         }
         for (int i=0; i<LENGTH(l); ++i) {
           SEXP li = VECTOR_ELT(l, i);
@@ -399,10 +461,10 @@ SEXP rbindlist(SEXP l, SEXP usenamesArg, SEXP fillArg, SEXP idcolArg, SEXP ignor
             const int n = length(levels);
             for (int k=0, last=0; k<n; ++k) {
               SEXP s = levelsD[k];
-              const int tl = TRUELENGTH(s);
-              if (tl>=last) {  // if tl>=0 then also tl>=last because last<=0
-                if (tl>=0) {
-                  snprintf(warnStr, sizeof(warnStr),   // not direct warning as we're inside tl region
+              const int pos = (int)hash_lookup(marks, s, 0);
+              if (pos<=last) {  // if pos==0 (not found) then also pos<=last because last>=0
+                if (pos==0) {
+                  snprintf(warnStr, sizeof(warnStr),   // not direct warning, to warn once after the levels are merged
                   _("Column %d of item %d is an ordered factor but level %d ['%s'] is missing from the ordered levels from column %d of item %d. " \
                     "Each set of ordered factor levels should be an ordered subset of the first longest. A regular factor will be created for this column."),
                   w+1, i+1, k+1, CHAR(s), longestW+1, longestI+1);
@@ -416,109 +478,102 @@ SEXP rbindlist(SEXP l, SEXP usenamesArg, SEXP fillArg, SEXP idcolArg, SEXP ignor
                 orderedFactor=false;
                 i=LENGTH(l);  // break outer i loop
                 break;        // break inner k loop
-                // we leave the tl set for the longest levels; the regular factor will be created with the longest ordered levels first in case that useful for user
+                // we leave the longest levels in the table; the regular factor will be created with the longest ordered levels first in case that useful for user
               }
-              last = tl;  // negative ordinal; last should monotonically grow more negative if the levels are an ordered subset of the longest
+              last = pos;  // position in the longest levels; should monotonically grow if the levels are an ordered subset of the longest
             }
           }
         }
       }
+      levelmap_t *maps = (levelmap_t *)R_alloc(LENGTH(l), sizeof(*maps));
+      int64_t nblock = 0;
+      int *targetd = INTEGER(target);
       for (int i=0; i<LENGTH(l); ++i) {
         const int thisnrow = eachMax[i];
+        nblock += (thisnrow + BLOCK_ROWS - 1) / BLOCK_ROWS;
+        maps[i] = (levelmap_t){ .id=NULL, .map=NULL, .sd=NULL, .val=NA_INTEGER, .dst=targetd+itemStart[i] };
         SEXP li = VECTOR_ELT(l, i);
         if (!length(li)) continue;  // NULL items in the list() of DT/DF; not if thisnrow==0 because we need to retain (unused) factor levels (#3508)
         int w = usenames ? colMap[i*ncol + j] : (j<length(li) ? j : -1); // check if j exceeds length for fill=TRUE and usenames=FALSE #5444
-        if (w==-1) {
-          writeNA(target, ansloc, thisnrow, false);
-        } else {
-          SEXP thisCol = VECTOR_ELT(li, w);
-          SEXP thisColStr = isFactor(thisCol) ? getAttrib(thisCol, R_LevelsSymbol) : (isString(thisCol) ? thisCol : VECTOR_ELT(coercedForFactor, i));
-          const int n = length(thisColStr);
-          const SEXP *thisColStrD = STRING_PTR_RO(thisColStr);  // D for data
-          for (int k=0; k<n; ++k) {
-            SEXP s = thisColStrD[k];
-            if (s==NA_STRING ||             // remove NA from levels; test 1979 found by package emil when revdep testing 1.12.2 (#3473)
-                TRUELENGTH(s)<0) continue;  // seen this level before; handles removing dups from levels as well as finding unique of character columns
-            if (TRUELENGTH(s)>0) savetl(s);
-            if (allocLevel==nLevel) {       // including initial time when allocLevel==nLevel==0
-              SEXP *tt = NULL;
-              if (allocLevel<INT_MAX) {
-                int64_t new = (int64_t)allocLevel+n-k+1024; // if all remaining levels in this item haven't been seen before, plus 1024 margin in case of many very short levels
-                allocLevel = (new>(int64_t)INT_MAX) ? INT_MAX : (int)new;
-                tt = realloc(levelsRaw, sizeof(SEXP)*allocLevel);  // first time levelsRaw==NULL and realloc==malloc in that case
-              }
-              if (tt==NULL) {
-                // # nocov start
-                // C spec states that if realloc() fails (above) the original block (levelsRaw) is left untouched: it is not freed or moved. We ...
-                for (int k=0; k<nLevel; k++) SET_TRUELENGTH(levelsRaw[k], 0);   // ... rely on that in this loop which uses levelsRaw.
-                free(levelsRaw);
-                savetl_end();
-                error(_("Failed to allocate working memory for %d factor levels of result column %d when reading item %d of item %d"), allocLevel, idcol+j+1, w+1, i+1);
-                // # nocov end
-              }
-              levelsRaw = tt;
-            }
-            SET_TRUELENGTH(s,-(++nLevel));
-            levelsRaw[nLevel-1] = s;
+        if (w==-1) continue;  // filled with NA
+        SEXP thisCol = VECTOR_ELT(li, w);
+        SEXP thisColStr = isFactor(thisCol) ? getAttrib(thisCol, R_LevelsSymbol) : (isString(thisCol) ? thisCol : VECTOR_ELT(coercedForFactor, i));
+        const int n = length(thisColStr);
+        const SEXP *thisColStrD = STRING_PTR_RO(thisColStr);  // D for data
+        for (int k=0; k<n; ++k) {
+          SEXP s = thisColStrD[k];
+          if (s==NA_STRING ||                // remove NA from levels; test 1979 found by package emil when revdep testing 1.12.2 (#3473)
+              hash_lookup(marks, s, 0)) continue;  // seen this level before; handles removing dups from levels as well as finding unique of character columns
+          if (allocLevel==nLevel) {          // including initial time when allocLevel==nLevel==0
+            if (allocLevel==INT_MAX)
+              internal_error(__func__, "more than %d factor levels in result column %d", INT_MAX, idcol+j+1); // # nocov
+            int64_t new = (int64_t)allocLevel+n-k+1024; // if all remaining levels in this item haven't been seen before, plus 1024 margin in case of many very short levels
+            allocLevel = (new>(int64_t)INT_MAX) ? INT_MAX : (int)new;
+            SEXP *tt = (SEXP *)R_alloc(allocLevel, sizeof(*tt));
+            if (nLevel) memcpy(tt, levelsRaw, nLevel*sizeof(*tt));
+            levelsRaw = tt;
           }
-          int *targetd = INTEGER(target);
-          if (isFactor(thisCol)) {
-            const int *id = INTEGER(thisCol);
-            if (length(thisCol)<=1) {
-              // recycle length-1, or NA-fill length-0
-              SEXP lev;
-              const int val = (length(thisCol)==1 && id[0]!=NA_INTEGER && (lev=thisColStrD[id[0]-1])!=NA_STRING) ? -TRUELENGTH(lev) : NA_INTEGER;
-              //                                                                                    ^^ #3915 and tests 2015.2-5
-              for (int r=0; r<thisnrow; ++r) targetd[ansloc+r] = val;
-            } else {
-              // length(thisCol)==thisnrow already checked before this truelength-clobber region
-              // If all i==truelength(i) then just do a memcpy since hop is identity. Otherwise hop via the integer map.
-              bool hop = false;
+          levelsRaw[nLevel++] = s;
+          hash_set(marks, s, nLevel);
+        }
+        if (isFactor(thisCol)) {
+          const int *id = INTEGER(thisCol);
+          if (length(thisCol)<=1) {
+            // recycle length-1, or NA-fill length-0
+            SEXP lev;
+            maps[i].val = (length(thisCol)==1 && id[0]!=NA_INTEGER && (lev=thisColStrD[id[0]-1])!=NA_STRING) ? (int)hash_lookup(marks, lev, NA_INTEGER) : NA_INTEGER;
+            //                                                                                                  ^^ #3915 and tests 2015.2-5
+          } else {
+            // length(thisCol)==thisnrow already checked up front
+            // If the codes of all the levels are the same in the result then the codes are copied as they are. Otherwise they hop via map.
+            int *map = (int *)R_alloc(n, sizeof(*map));
+            bool hop = false;
+            for (int k=0; k<n; ++k) {
+              SEXP s = thisColStrD[k];
               if (orderedFactor) {
                 // retain the position of NA level (if any) and the integer mappings to it
-                for (int k=0; k<n; ++k) {
-                  SEXP s = thisColStrD[k];
-                  if (s!=NA_STRING && -TRUELENGTH(s)!=k+1) { hop=true; break; }
-                }
-              } else {
-                for (int k=0; k<n; ++k) {
-                  SEXP s = thisColStrD[k];
-                  if (s==NA_STRING || -TRUELENGTH(s)!=k+1) { hop=true; break; }
-                }
-              }
-              if (hop) {
-                if (orderedFactor) {
-                  for (int r=0; r<thisnrow; ++r)
-                    targetd[ansloc+r] = id[r]==NA_INTEGER ? NA_INTEGER : -TRUELENGTH(thisColStrD[id[r]-1]);
-                } else {
-                  for (int r=0; r<thisnrow; ++r) {
-                    SEXP lev;
-                    targetd[ansloc+r] = id[r]==NA_INTEGER || (lev=thisColStrD[id[r]-1])==NA_STRING ? NA_INTEGER : -TRUELENGTH(lev);
-                  }
-                }
+                map[k] = (int)hash_lookup(marks, s, NA_INTEGER);
+                if (s!=NA_STRING && map[k]!=k+1) hop=true;
               } else {
-                memcpy(targetd+ansloc, id, thisnrow*RTYPE_SIZEOF(thisCol));
+                map[k] = s==NA_STRING ? NA_INTEGER : (int)hash_lookup(marks, s, NA_INTEGER);
+                if (map[k]!=k+1) hop=true;
               }
             }
+            maps[i].id = id;
+            if (hop) maps[i].map = map;
+          }
+        } else {
+          const SEXP *sd = STRING_PTR_RO(thisColStr);
+          if (length(thisCol)<=1) {
+            maps[i].val = (length(thisCol)==1 && sd[0]!=NA_STRING) ? (int)hash_lookup(marks, sd[0], NA_INTEGER) : NA_INTEGER;
           } else {
-            const SEXP *sd = STRING_PTR_RO(thisColStr);
-            if (length(thisCol)<=1) {
-              const int val = (length(thisCol)==1 && sd[0]!=NA_STRING) ? -TRUELENGTH(sd[0]) : NA_INTEGER;
-              for (int r=0; r<thisnrow; ++r) targetd[ansloc+r] = val;
-            } else {
-              for (int r=0; r<thisnrow; ++r) targetd[ansloc+r] = sd[r]==NA_STRING ? NA_INTEGER : -TRUELENGTH(sd[r]);
-            }
+            maps[i].sd = sd;
           }
         }
-        ansloc += thisnrow;
       }
-      for (int k=0; k<nLevel; ++k) SET_TRUELENGTH(levelsRaw[k], 0);
-      savetl_end();
-      if (warnStr[0]) warning("%s", warnStr);  // # notranslate. now savetl_end() has happened it's safe to call warning (could error if options(warn=2))
+      rowblock_t *blocks = (rowblock_t *)R_alloc(nblock, sizeof(*blocks));
+      for (int i=0, b=0; i<LENGTH(l); ++i) {
+        for (int from=0; from<eachMax[i]; from+=BLOCK_ROWS)
+          blocks[b++] = (rowblock_t){ .item=i, .from=from, .to=(eachMax[i]-from > BLOCK_ROWS ? from+BLOCK_ROWS : eachMax[i]) };
+      }
+      #pragma omp parallel for schedule(dynamic) num_threads(getDTthreads(nblock, false))
+      for (int64_t b=0; b<nblock; ++b) {
+        const levelmap_t m = maps[blocks[b].item];
+        const int from = blocks[b].from, to = blocks[b].to;
+        if (m.id && m.map) {
+          for (int r=from; r<to; ++r) m.dst[r] = m.id[r]==NA_INTEGER ? NA_INTEGER : m.map[m.id[r]-1];
+        } else if (m.id) {
+          memcpy(m.dst+from, m.id+from, (to-from)*sizeof(*m.dst));
+        } else if (m.sd) {
+          for (int r=from; r<to; ++r) m.dst[r] = m.sd[r]==NA_STRING ? NA_INTEGER : (int)hash_lookup(marks, m.sd[r], NA_INTEGER);
+        } else {
+          for (int r=from; r<to; ++r) m.dst[r] = m.val;
+        }
+      }
+      if (warnStr[0]) warning("%s", warnStr);  // # notranslate
       SEXP levelsSxp;
       setAttrib(target, R_LevelsSymbol, levelsSxp=allocVector(STRSXP, nLevel));
       for (int k=0; k<nLevel; ++k) SET_STRING_ELT(levelsSxp, k, levelsRaw[k]);
-      free(levelsRaw);
       if (orderedFactor) {
         SEXP tt;
         setAttrib(target, R_ClassSymbol, tt=allocVector(STRSXP, 2));
@@ -528,6 +583,8 @@ SEXP rbindlist(SEXP l, SEXP usenamesArg, SEXP fillArg, SEXP idcolArg, SEXP ignor
         setAttrib(target, R_ClassSymbol, ScalarString(char_factor));
       }
     } else {  // factor==false
+      const int targetType = TYPEOF(target);
+      const bool targetIsI64 = targetType==REALSXP && INHERITS(target, char_integer64);
       for (int i=0; i<LENGTH(l); ++i) {
         const int thisnrow = eachMax[i];
         if (thisnrow==0) continue;
@@ -535,7 +592,11 @@ SEXP rbindlist(SEXP l, SEXP usenamesArg, SEXP fillArg, SEXP idcolArg, SEXP ignor
         int w = usenames ? colMap[i*ncol + j] : (j<length(li) ? j : -1); // check if j exceeds length for fill=TRUE and usenames=FALSE #5444
         SEXP thisCol;
         if (w==-1 || !length(thisCol=VECTOR_ELT(li, w))) {  // !length for zeroCol warning above; #1871
-          writeNA(target, ansloc, thisnrow, false);  // writeNA is integer64 aware and writes INT64_MIN
+          writeNA(target, itemStart[i], thisnrow, false);  // writeNA is integer64 aware and writes INT64_MIN
+        } else if (TYPEOF(thisCol)==targetType && length(thisCol)==thisnrow && targetType!=STRSXP && targetType!=VECSXP && targetType!=EXPRSXP &&
+                   (targetType!=REALSXP || INHERITS(thisCol, char_integer64)==targetIsI64)) {
+          // same type and no recycling, so memrecycle would memcpy; deferred to be copied in parallel with the other columns below
+          addcopyblocks(&copies, colptr(thisCol), (char *)colptr(target) + (size_t)itemStart[i]*RTYPE_SIZEOF(target), thisnrow, RTYPE_SIZEOF(target));
         } else {
           bool listprotect = (TYPEOF(target)==VECSXP || TYPEOF(target)==EXPRSXP) && TYPEOF(thisCol)!=TYPEOF(target);
           // do an as.list() on the atomic column; #3528
@@ -543,20 +604,24 @@ SEXP rbindlist(SEXP l, SEXP usenamesArg, SEXP fillArg, SEXP idcolArg, SEXP ignor
             // coerceAs for int64 to copy attributes (coerceVector does not copy atts)
             thisCol = PROTECT(INHERITS(thisCol, char_integer64) ? coerceAs(thisCol, target, ScalarLogical(TRUE)) : coerceVector(thisCol, TYPEOF(target)));
             // else coerces if needed within memrecycle; with a no-alloc direct coerce from 1.12.4 (PR #3909)
-            const char *ret = memrecycle(target, R_NilValue, ansloc, thisnrow, thisCol, 0, -1, idcol+j+1, foundName);
+            const char *ret = memrecycle(target, R_NilValue, itemStart[i], thisnrow, thisCol, 0, -1, idcol+j+1, foundName);
             UNPROTECT(1); // earlier unprotect rbindlist calls with lots of lists #4536
             if (ret) warning(_("Column %d of item %d: %s"), w+1, i+1, ret);
           } else {
-            const char *ret = memrecycle(target, R_NilValue, ansloc, thisnrow, thisCol, 0, -1, idcol+j+1, foundName);
+            const char *ret = memrecycle(target, R_NilValue, itemStart[i], thisnrow, thisCol, 0, -1, idcol+j+1, foundName);
             if (ret) warning(_("Column %d of item %d: %s"), w+1, i+1, ret);
           }
           // e.g. when precision is lost like assigning 3.4 to integer64; test 2007.2
           // TODO: but maxType should handle that and this should never warn
         }
-        ansloc += thisnrow;
       }
     }
   }
+  // the same-type columns of the items, typically the bulk of the result, in parallel over (column, item) blocks
+  #pragma omp parallel for schedule(dynamic) num_threads(getDTthreads(copies.n, false))
+  for (int64_t b=0; b<copies.n; ++b) {
+    memcpy(copies.b[b].dst, copies.b[b].src, copies.b[b].size);
+  }
   UNPROTECT(nprotect); // ans, ansNames, coercedForFactor?
   return(ans);
 }
@@ -1,7 +1,61 @@
 #include "data.table.h"
 #include <Rdefines.h>
 
-SEXP shift(SEXP obj, SEXP k, SEXP fill, SEXP type)
+// shift within groups: rows are taken in the order o (1-based, NULL when rows are already grouped) where groups start at
+// gs (0-based positions in that order). Each row is written once to its own place in tmp, so all groups are filled in a
+// single pass over the rows, in parallel over groups, and nothing is allocated per group
+static void shiftGrouped(SEXP elem, SEXP thisfill, SEXP tmp, int kj, bool lag, bool cycle, const int *o, const int *gs, int ngrp)
+{
+  const int64_t n = xlength(elem), m = kj<0 ? -(int64_t)kj : kj;
+  int nth = isVectorAtomic(elem) && !isString(elem) ? getDTthreads(ngrp, true) : 1; // SET_STRING_ELT and SET_VECTOR_ELT are not thread safe
+  #define GSHIFT(CTYPE, SRC, FILL, ASSIGN) {                                     \
+    _Pragma("omp parallel for num_threads(nth)")                                 \
+    for (int g=0; g<ngrp; g++) {                                                 \
+      const int64_t from = gs[g], to = g+1<ngrp ? gs[g+1] : n, len = to-from;    \
+      const int64_t thisk = cycle ? m % len : MIN(m, len);                       \
+      for (int64_t p=from; p<to; p++) {                                          \
+        int64_t q = lag ? p-thisk : p+thisk;                                     \
+        if (q < from || q >= to)                                                 \
+          q = cycle ? (lag ? q+len : q-len) : -1;                                \
+        const int64_t i = o ? o[p]-1 : p;                                        \
+        const CTYPE val = q<0 ? FILL : SRC[o ? o[q]-1 : q];                      \
+        ASSIGN;                                                                  \
+      }                                                                          \
+    }                                                                            \
+  }
+  switch (TYPEOF(elem)) {
+  case INTSXP: case LGLSXP: {
+    const int *ielem = INTEGER_RO(elem); int *itmp = INTEGER(tmp);
+    GSHIFT(int, ielem, INTEGER(thisfill)[0], itmp[i]=val);
+  } break;
+  case REALSXP: {
+    const double *delem = REAL_RO(elem); double *dtmp = REAL(tmp);
+    GSHIFT(double, delem, REAL(thisfill)[0], dtmp[i]=val);
+  } break;
+  case CPLXSXP: {
+    const Rcomplex *celem = COMPLEX_RO(elem); Rcomplex *ctmp = COMPLEX(tmp);
+    GSHIFT(Rcomplex, celem, COMPLEX(thisfill)[0], ctmp[i]=val);
+  } break;
+  case RAWSXP: {
+    const Rbyte *relem = RAW_RO(elem); Rbyte *rtmp = RAW(tmp);
+    GSHIFT(Rbyte, relem, RAW(thisfill)[0], rtmp[i]=val);
+  } break;
+  case STRSXP: {
+    const SEXP *selem = STRING_PTR_RO(elem);
+    GSHIFT(SEXP, selem, STRING_ELT(thisfill, 0), SET_STRING_ELT(tmp, i, val));
+  } break;
+  case VECSXP: {
+    const SEXP *velem = SEXPPTR_RO(elem);
+    GSHIFT(SEXP, velem, VECTOR_ELT(thisfill, 0), SET_VECTOR_ELT(tmp, i, val));
+  } break;
+  default:
+    error(_("Type '%s' is not supported"), type2char(TYPEOF(elem)));
+  }
+  #undef GSHIFT
+}
+
+// o and starts are NULL, or forderv(by, retGrp=TRUE) and its starts attribute to shift within groups
+SEXP shift(SEXP obj, SEXP k, SEXP fill, SEXP type, SEXP o, SEXP starts)
 {
   int nprotect=0;
   enum {LAG, LEAD/*, SHIFT*/,CYCLIC} stype = LAG; // currently SHIFT maps to LAG (see comments in #1708)
@@ -35,6 +89,20 @@ SEXP shift(SEXP obj, SEXP k, SEXP fill, SEXP type)
 
   const bool cycle = stype == CYCLIC;
 
+  const int *io = NULL, *gs = NULL;
+  int ngrp = 0;
+  if (!isNull(starts)) {
+    if (!isInteger(starts) || (!isNull(o) && !isInteger(o)))
+      internal_error(__func__, "o and starts must be integer"); // # nocov
+    if (length(o))
+      io = INTEGER_RO(o);
+    ngrp = length(starts);
+    const int *is = INTEGER_RO(starts);
+    int *igs = (int *)R_alloc(ngrp, sizeof(*igs));
+    for (int g=0; g<ngrp; g++) igs[g] = is[g]-1;
+    gs = igs;
+  }
+
   SEXP ans = PROTECT(allocVector(VECSXP, nk * nx)); nprotect++;
   for (int i=0; i<nx; i++) {
     SEXP elem  = VECTOR_ELT(x, i);
@@ -47,6 +115,20 @@ SEXP shift(SEXP obj, SEXP k, SEXP fill, SEXP type)
             elem_type, fill_type, elem_type);
     }
     SEXP thisfill = PROTECT(coerceAs(fill, elem, ScalarLogical(0)));  // #4865 use coerceAs for type coercion
+    if (gs) {
+      if (io && xrows!=length(o))
+        internal_error(__func__, "length of order %d does not match length of column %d, %"PRId64, length(o), i+1, (int64_t)xrows); // # nocov
+      for (int j=0; j<nk; j++) {
+        SEXP tmp;
+        SET_VECTOR_ELT(ans, i*nk+j, tmp=allocVector(TYPEOF(elem), xrows) );
+        const bool lag = ((stype == LAG || stype == CYCLIC) && kd[j] >= 0) || (stype == LEAD && kd[j] < 0);
+        shiftGrouped(elem, thisfill, tmp, kd[j], lag, cycle, io, gs, ngrp);
+        copyMostAttrib(elem, tmp);
+        if (isFactor(elem)) setAttrib(tmp, R_LevelsSymbol, getAttrib(elem, R_LevelsSymbol));
+      }
+      UNPROTECT(1); // thisfill
+      continue;
+    }
     switch (TYPEOF(elem)) {
     case INTSXP: case LGLSXP: {
       const int ifill = INTEGER(thisfill)[0];
@@ -1,5 +1,78 @@
 #include "data.table.h"
 
+/* uniqlist and rleid find where runs of equal rows start in parallel
+ *   1) rows are cut into one chunk per thread, a multiple of 64 rows each, and every chunk marks the rows that differ
+ *      from the row before in a bit mask (no word of which is shared by two chunks) and counts them
+ *   2) the running total of the counts gives the number of runs before each chunk
+ *   3) each chunk writes its part of the answer from its bits, which are not compared again
+ */
+
+typedef struct {
+  SEXPTYPE type;
+  const void *p;
+  bool twiddle;  // doubles with different bits are still equal when dtwiddle() is
+} runcol_t;
+
+static inline bool rowsame(const runcol_t *rc, int ncol, int64_t a, int64_t b)
+{
+  for (int j=ncol-1; j>=0; --j) {  // the last column varies the most frequently so check that first and work backwards
+    const runcol_t *c = rc+j;
+    bool same;
+    switch (c->type) {
+    case INTSXP : case LGLSXP :  // NA_INTEGER==NA_LOGICAL checked in init.c
+      same = ((const int *)c->p)[a] == ((const int *)c->p)[b];
+      break;
+    case STRSXP :
+      same = ((const SEXP *)c->p)[a] == ((const SEXP *)c->p)[b];
+      break;
+    case REALSXP :
+      same = ((const uint64_t *)c->p)[a] == ((const uint64_t *)c->p)[b] ||
+             (c->twiddle && dtwiddle(((const double *)c->p)[a]) == dtwiddle(((const double *)c->p)[b]));
+      break;
+    default : // CPLXSXP
+      same = memcmp((const Rcomplex *)c->p + a, (const Rcomplex *)c->p + b, sizeof(Rcomplex))==0;
+    }
+    if (!same) return false;
+  }
+  return true;
+}
+
+typedef struct {
+  int nchunk;
+  int64_t chunk;     // rows in each chunk but the last, a multiple of 64
+  uint64_t *bits;    // bit i is set when row i starts a run
+  int64_t *before;   // number of runs starting before each chunk, and the total at the end
+} runstarts_t;
+
+// rows are taken in the order o (1-based) when o is not NULL
+static runstarts_t runstarts(const runcol_t *rc, int ncol, const int *o, int64_t n)
+{
+  runstarts_t rs;
+  int nth = getDTthreads(n, true);
+  rs.chunk = ((n + nth - 1) / nth + 63) / 64 * 64;
+  if (!rs.chunk) rs.chunk = 64;
+  rs.nchunk = (int)((n + rs.chunk - 1) / rs.chunk);
+  nth = rs.nchunk ? rs.nchunk : 1;
+  rs.bits = (uint64_t *)R_alloc((n + 63) / 64, sizeof(*rs.bits));
+  rs.before = (int64_t *)R_alloc(rs.nchunk + 1, sizeof(*rs.before));
+  #pragma omp parallel for num_threads(nth)
+  for (int c=0; c<rs.nchunk; ++c) {
+    const int64_t from = c*rs.chunk, to = n-from > rs.chunk ? from+rs.chunk : n;
+    memset(rs.bits + from/64, 0, (to-from+63)/64 * sizeof(*rs.bits));
+    int64_t cnt = 0;
+    for (int64_t i=from; i<to; ++i) {
+      if (i==0 || !rowsame(rc, ncol, o ? o[i]-1 : i, o ? o[i-1]-1 : i-1)) {
+        rs.bits[i/64] |= (uint64_t)1 << (i%64);
+        cnt++;
+      }
+    }
+    rs.before[c+1] = cnt;
+  }
+  rs.before[0] = 0;
+  for (int c=0; c<rs.nchunk; ++c) rs.before[c+1] += rs.before[c];
+  return rs;
+}
+
 // DONE: return 'uniqlist' as a vector (same as duplist) and write a separate function to get group sizes
 // Also improvements for numeric type with a hack of checking unsigned int (to overcome NA/NaN/Inf/-Inf comparisons) (> 2x speed-up)
 SEXP uniqlist(SEXP l, SEXP order)
@@ -7,10 +80,8 @@ SEXP uniqlist(SEXP l, SEXP order)
   // This works like UNIX uniq as referred to by ?base::unique; i.e., it
   // drops immediately repeated rows but doesn't drop duplicates of any
   // previous row. Unless, order is provided, then it also drops any previous
-  // row. l must be a list of same length vectors ans is allocated first
-  // (maximum length the number of rows) and the length returned in anslen.
+  // row. l must be a list of same length vectors.
   // No NA in order which is guaranteed since internal-only. Used at R level internally (Cuniqlist) but is not and should not be exported.
-  // DONE: ans is now grown
   if (!isNewList(l)) internal_error(__func__, "l is not a list of columns"); // # nocov
   R_len_t ncol = length(l);
   R_len_t nrow = length(VECTOR_ELT(l,0));
@@ -18,131 +89,46 @@ SEXP uniqlist(SEXP l, SEXP order)
   if (LENGTH(order)<1) internal_error(__func__, "order is length-0"); // # nocov
   if (LENGTH(order)>1 && LENGTH(order)!=nrow) internal_error(__func__, "length(order)==%d but nrow==%d", LENGTH(order), nrow); // # nocov
   bool via_order = INTEGER(order)[0] != -1;  // has an ordering vector been passed in that we have to hop via? Don't use MISSING() here as it appears unstable on Windows
+  if (nrow==0) return ScalarInteger(1);  // first row is always the first of the first group
 
-  unsigned long long *ulv; // for numeric check speed-up
-  SEXP v, ans;
-  R_len_t len, thisi, previ, isize=1000;
-  int *iidx = R_Calloc(isize, int); // for 'idx'
-  len = 1;
-  iidx[0] = 1; // first row is always the first of the first group
-
-  if (ncol==1) {
-
-#define COMPARE1                                                                 \
-      prev = *vd;                                                                \
-      for (int i=1; i<nrow; i++) {                                               \
-        elem = *++vd;                                                            \
-        if (elem!=prev
-
-#define COMPARE1_VIA_ORDER                                                       \
-      prev = vd[*o -1];                                                          \
-      for (int i=1; i<nrow; i++) {                                               \
-        elem = vd[*++o -1];                                                      \
-        if (elem!=prev
-
-#define COMPARE2                                                                 \
-                        ) {                                                      \
-          iidx[len++] = i+1;                                                     \
-          if (len>=isize) {                                                      \
-            isize = MIN(nrow, (size_t)(1.1*(double)isize*((double)nrow/i)));     \
-            iidx = R_Realloc(iidx, isize, int);                                  \
-          }                                                                      \
-        }                                                                        \
-        prev = elem;                                                             \
-      }
-
-    SEXP v = VECTOR_ELT(l,0);
-    int *o = INTEGER(order);  // only used when via_order is true
-    switch(TYPEOF(v)) {
-    case INTSXP : case LGLSXP : {
-      const int *vd=INTEGER(v);
-      int prev, elem;
-      if (via_order) {
-        // ad hoc by (order passed in)
-        COMPARE1_VIA_ORDER COMPARE2
-      } else {
-        // e.g. by=key(DT)[1]
-        COMPARE1           COMPARE2
-      }
-    } break;
-    case STRSXP : {
-      const SEXP *vd=STRING_PTR_RO(v);
-      SEXP prev, elem;
-      if (via_order) {
-        COMPARE1_VIA_ORDER && ENC2UTF8(elem)!=ENC2UTF8(prev) COMPARE2   // but most of the time they are equal, so ENC2UTF8 doesn't need to be called
-      } else {
-        COMPARE1           && ENC2UTF8(elem)!=ENC2UTF8(prev) COMPARE2
-      }
-    } break;
-    case REALSXP : {
+  // marked non-utf8 encodings are converted to utf8 up front so as to match properly when inputs are of different
+  // encodings (#469), and so that strings compare by pointer on many threads
+  SEXP utf8 = PROTECT(allocVector(VECSXP, ncol));
+  runcol_t *rc = (runcol_t *)R_alloc(ncol, sizeof(*rc));
+  for (int j=0; j<ncol; j++) {
+    SEXP v = VECTOR_ELT(l, j);
+    rc[j] = (runcol_t){ .type=TYPEOF(v), .p=NULL, .twiddle=false };
+    switch (TYPEOF(v)) {
+    case INTSXP : case LGLSXP :
+      rc[j].p = INTEGER_RO(v);
+      break;
+    case STRSXP :
+      SET_VECTOR_ELT(utf8, j, v = coerceUtf8IfNeeded(v));
+      rc[j].p = STRING_PTR_RO(v);
+      break;
+    case REALSXP :
       // grouping by integer64 makes sense (ids). grouping by float supported but a good use-case for that is harder to imagine
-      if (getNumericRounding_C()==0 /*default*/ || inherits(v, "integer64")) {
-        const uint64_t *vd=(const uint64_t *)REAL(v);
-        uint64_t prev, elem;
-        if (via_order) {
-          COMPARE1_VIA_ORDER COMPARE2
-        } else {
-          COMPARE1           COMPARE2
-        }
-      } else {
-        const double *vd=(const double *)REAL(v);
-        double prev, elem;
-        if (via_order) {
-          COMPARE1_VIA_ORDER && dtwiddle(elem)!=dtwiddle(prev) COMPARE2
-        } else {
-          COMPARE1           && dtwiddle(elem)!=dtwiddle(prev) COMPARE2
-        }
-      }
-    } break;
+      // the bits of one column are compared as they are when there's no rounding, several columns compare by dtwiddle too
+      rc[j].p = REAL_RO(v);
+      rc[j].twiddle = !INHERITS(v, char_integer64) && (ncol>1 || getNumericRounding_C()!=0);
+      break;
     default : // # nocov
       error(_("Type '%s' is not supported"), type2char(TYPEOF(v)));  // # nocov
     }
-  } else {
-    // ncol>1
-    thisi = via_order ? INTEGER(order)[0]-1 : 0;
-    bool *i64 = (bool *)R_alloc(ncol, sizeof(*i64));
-    for (int i=0; i<ncol; i++) i64[i] = INHERITS(VECTOR_ELT(l,i), char_integer64);
-    for (int i=1; i<nrow; i++) {
-      previ = thisi;
-      thisi = via_order ? INTEGER(order)[i]-1 : i;
-      int j = ncol;  // the last column varies the most frequently so check that first and work backwards
-      bool b = true;
-      while (--j>=0 && b) {
-        v=VECTOR_ELT(l,j);
-        switch (TYPEOF(v)) {
-        case INTSXP : case LGLSXP :  // NA_INTEGER==NA_LOGICAL checked in init.c
-          b=INTEGER(v)[thisi]==INTEGER(v)[previ]; break;
-        case STRSXP :
-          // fix for #469, when key is set, duplicated calls uniqlist, where encoding
-          // needs to be taken care of.
-          b=ENC2UTF8(STRING_ELT(v,thisi))==ENC2UTF8(STRING_ELT(v,previ)); break;  // marked non-utf8 encodings are converted to utf8 so as to match properly when inputs are of different encodings.
-          // TODO: surely faster way than this two deep STRING_ELT()
-        case REALSXP :
-          ulv = (unsigned long long *)REAL(v);
-          b = ulv[thisi] == ulv[previ]; // (gives >=2x speedup)
-          if (!b && !i64[j]) {
-            b = dtwiddle(REAL(v)[thisi]) == dtwiddle(REAL(v)[previ]);
-            // could store LHS for use next time as RHS (to save calling dtwiddle twice). However: i) there could be multiple double columns so vector of RHS would need
-            // to be stored, ii) many short-circuit early before the if (!b) anyway (negating benefit) and iii) we may not have needed LHS this time so logic would be complex.
-          }
-          break;
-        default : // # nocov
-          error(_("Type '%s' is not supported"), type2char(TYPEOF(v)));  // # nocov
-        }
-      }
-      if (!b) {
-        iidx[len++] = i+1;
-        if (len >= isize) {
-          isize = MIN(nrow, (size_t)(1.1*(double)isize*((double)nrow/i)));
-          iidx = R_Realloc(iidx, isize, int);
-        }
-      }
+  }
+  const runstarts_t rs = runstarts(rc, ncol, via_order ? INTEGER_RO(order) : NULL, nrow);
+  SEXP ans = PROTECT(allocVector(INTSXP, rs.before[rs.nchunk]));
+  int *ians = INTEGER(ans);
+  #pragma omp parallel for num_threads(getDTthreads(rs.nchunk, false))
+  for (int c=0; c<rs.nchunk; ++c) {
+    const int64_t from = c*rs.chunk, to = nrow-from > rs.chunk ? from+rs.chunk : nrow;
+    int64_t k = rs.before[c];
+    for (int64_t w=from/64; w<(to+63)/64; ++w) {
+      uint64_t word = rs.bits[w];  // bits past the last row are never set
+      for (int b=0; word; ++b, word>>=1) if (word & 1) ians[k++] = (int)(w*64 + b) + 1;
     }
   }
-  PROTECT(ans = allocVector(INTSXP, len));
-  memcpy(INTEGER(ans), iidx, sizeof(int)*len); // sizeof is of type size_t - no integer overflow issues
-  R_Free(iidx);
-  UNPROTECT(1);
+  UNPROTECT(2);
   return(ans);
 }
 
@@ -156,6 +142,7 @@ SEXP uniqlengths(SEXP x, SEXP n) {
   const int *px = INTEGER_RO(x);
   int *pans = INTEGER(ans);
 
+  #pragma omp parallel for num_threads(getDTthreads(len, true))
   for (R_len_t i=1; i<len; i++) {
       pans[i-1] = px[i] - px[i-1];
   }
@@ -180,94 +167,47 @@ SEXP rleid(SEXP l, SEXP cols) {
   for (int i=1; i<ncol; i++) {
     if (xlength(VECTOR_ELT(l,i)) != nrow) error(_("All elements to input list must be of same length. Element [%d] has length %"PRIu64" != length of first element = %"PRIu64"."), i+1, (uint64_t)xlength(VECTOR_ELT(l,i)), (uint64_t)nrow);
   }
-  SEXP ans = PROTECT(allocVector(INTSXP, nrow));
-  int *ians = INTEGER(ans);
-  int grp = 1;
-  ians[0] = grp; // first row is always the first of first group
-  if (ncol > 1) {
-    for (R_xlen_t i=1; i<nrow; i++) {
-      bool same = true;
-      int j = lencols;
-      // the last column varies the most frequently so check that first and work backwards
-      while (--j>=0 && same) {
-        SEXP jcol = VECTOR_ELT(l, icols[j]-1);
-        switch (TYPEOF(jcol)) {
-        case INTSXP : case LGLSXP :
-          same = INTEGER(jcol)[i]==INTEGER(jcol)[i-1];
-          break;
-        case STRSXP :
-          same = STRING_ELT(jcol,i)==STRING_ELT(jcol,i-1);
-          // TODO: do we want to check encodings here now that forder seems to?
-          // Old comment : forder checks no non-ascii unknown, and either UTF-8 or Latin1 but not both.
-          //               So == pointers is ok given that check
-          break;
-        case REALSXP : {
-          long long *ll = (long long *)REAL(jcol);
-          same = ll[i]==ll[i-1];
-          // 8 bytes of bits are identical. For real (no rounding currently) and integer64
-          // long long == 8 bytes checked in init.c
-        } break;
-        case CPLXSXP: {
-          Rcomplex *pz = COMPLEX(jcol);
-          same = memcmp(&pz[i], &pz[i-1], sizeof(Rcomplex))==0; // compiler optimization should replace library call with best 16-byte fixed method
-        } break;
-        default : // # nocov
-          error(_("Type '%s' is not supported"), type2char(TYPEOF(jcol)));  // # nocov
-        }
-      }
-      ians[i] = (grp+=!same);
-    }
-  } else { // we are checking only one column so we can easily takes inline R functions out of the loops
-    SEXP jcol = VECTOR_ELT(l, icols[0]-1);
+  runcol_t *rc = (runcol_t *)R_alloc(lencols, sizeof(*rc));
+  for (int j=0; j<lencols; j++) {
+    SEXP jcol = VECTOR_ELT(l, icols[j]-1);
     switch (TYPEOF(jcol)) {
-    case INTSXP : case LGLSXP : {
-      int *ijcol = INTEGER(jcol);
-      for (R_xlen_t i=1; i<nrow; i++) {
-        bool same = ijcol[i]==ijcol[i-1];
-        ians[i] = (grp+=!same);
-      }
-    } break;
-    case STRSXP : {
-      const SEXP *jd = STRING_PTR_RO(jcol);
-      for (R_xlen_t i=1; i<nrow; i++) {
-        bool same = jd[i]==jd[i-1];
-        ians[i] = (grp+=!same);
-      }
-    } break;
-    case REALSXP : {
-      long long *lljcol = (long long *)REAL(jcol);
-      for (R_xlen_t i=1; i<nrow; i++) {
-        bool same = lljcol[i]==lljcol[i-1];
-        ians[i] = (grp+=!same);
-      }
-    } break;
-    case CPLXSXP: {
-      Rcomplex *pzjcol = COMPLEX(jcol);
-      for (R_xlen_t i=1; i<nrow; i++) {
-        bool same = memcmp(&pzjcol[i], &pzjcol[i-1], sizeof(Rcomplex))==0;
-        ians[i] = (grp += !same);
-      }
-    } break;
+    case INTSXP : case LGLSXP : case REALSXP : case CPLXSXP :
+      // 8 bytes of bits are identical for real (no rounding currently) and integer64
+      rc[j] = (runcol_t){ .type=TYPEOF(jcol), .p=DATAPTR_RO(jcol), .twiddle=false };
+      break;
+    case STRSXP :
+      // TODO: do we want to check encodings here now that forder seems to?
+      // Old comment : forder checks no non-ascii unknown, and either UTF-8 or Latin1 but not both.
+      //               So == pointers is ok given that check
+      rc[j] = (runcol_t){ .type=STRSXP, .p=STRING_PTR_RO(jcol), .twiddle=false };
+      break;
     default :
       error(_("Type '%s' is not supported"), type2char(TYPEOF(jcol)));
     }
   }
+  const runstarts_t rs = runstarts(rc, lencols, NULL, nrow);
+  SEXP ans = PROTECT(allocVector(INTSXP, nrow));
+  int *ians = INTEGER(ans);
+  #pragma omp parallel for num_threads(getDTthreads(rs.nchunk, false))
+  for (int c=0; c<rs.nchunk; ++c) {
+    const int64_t from = c*rs.chunk, to = nrow-from > rs.chunk ? from+rs.chunk : nrow;
+    int grp = (int)rs.before[c];
+    for (int64_t i=from; i<to; ++i) {
+      grp += (int)(rs.bits[i/64] >> (i%64) & 1);
+      ians[i] = grp;
+    }
+  }
   UNPROTECT(1);
   return(ans);
 }
 
 SEXP nestedid(SEXP l, SEXP cols, SEXP order, SEXP grps, SEXP resetvals, SEXP multArg) {
   Rboolean byorder = (length(order)>0);
-  SEXP v, ans;
   if (!isNewList(l) || length(l) < 1) internal_error(__func__, "l is not a list length 1 or more"); // # nocov
   R_len_t nrows = length(VECTOR_ELT(l,0)), ncols = length(cols);
   if (nrows==0) return(allocVector(INTSXP, 0));
-  R_len_t thisi, previ, ansgrpsize=1000, nansgrp=0;
-  R_len_t *ansgrp = R_Calloc(ansgrpsize, R_len_t), starts, grplen; // #3401 fix. Needs to be R_Calloc due to R_Realloc below .. else segfaults.
   R_len_t ngrps = length(grps);
-  bool *i64 = (bool *)R_alloc(ncols, sizeof(*i64));
   if (ngrps==0) internal_error(__func__, "nrows[%d]>0 but ngrps==0", nrows); // # nocov
-  R_len_t resetctr=0, rlen = length(resetvals) ? INTEGER(resetvals)[0] : 0;
   if (!isInteger(cols) || ncols == 0) error(_("cols must be an integer vector with length >= 1"));
   // mult arg
   enum {ALL, FIRST, LAST} mult = ALL;
@@ -275,79 +215,113 @@ SEXP nestedid(SEXP l, SEXP cols, SEXP order, SEXP grps, SEXP resetvals, SEXP mul
   else if (!strcmp(CHAR(STRING_ELT(multArg, 0)), "first")) mult = FIRST;
   else if (!strcmp(CHAR(STRING_ELT(multArg, 0)), "last")) mult = LAST;
   else internal_error(__func__, "invalid value for 'mult'"); // # nocov
-  // integer64
+  // columns are read through pointers so that segments can be done on many threads; strings are made UTF-8 first since
+  // ENC2UTF8 may allocate
+  SEXP utf8 = PROTECT(allocVector(VECSXP, ncols));
+  runcol_t *nc = (runcol_t *)R_alloc(ncols, sizeof(*nc));
   for (int j=0; j<ncols; j++) {
-    i64[j] = INHERITS(VECTOR_ELT(l, INTEGER(cols)[j]-1), char_integer64);
-  }
-  ans  = PROTECT(allocVector(INTSXP, nrows));
-  int *ians = INTEGER(ans), *igrps = INTEGER(grps);
-  grplen = (ngrps == 1) ? nrows : igrps[1]-igrps[0];
-  starts = igrps[0]-1 + (mult != LAST ? 0 : grplen-1);
-  ansgrp[0] = byorder ? INTEGER(order)[starts]-1 : starts;
-  for (int j=0; j<grplen; j++) {
-    ians[byorder ? INTEGER(order)[igrps[0]-1+j]-1 : igrps[0]-1+j] = 1;
+    SEXP v = VECTOR_ELT(l, INTEGER(cols)[j]-1);
+    nc[j] = (runcol_t){ .type=TYPEOF(v), .p=NULL, .twiddle=false };
+    switch(TYPEOF(v)) {
+    case INTSXP: case LGLSXP:
+      nc[j].p = INTEGER_RO(v);
+      break;
+    case STRSXP :
+      SET_VECTOR_ELT(utf8, j, v = coerceUtf8IfNeeded(v));
+      nc[j].p = STRING_PTR_RO(v);
+      break;
+    case REALSXP:
+      nc[j].p = REAL_RO(v);
+      nc[j].twiddle = !INHERITS(v, char_integer64);  // integer64 compares as int64_t
+      break;
+    default: // # nocov
+      if (j) error(_("Type '%s' is not supported"), type2char(TYPEOF(v)));  // # nocov ; the first column is never compared here
+    }
   }
-  nansgrp = 1;
+  SEXP ans = PROTECT(allocVector(INTSXP, nrows));
+  int *ians = INTEGER(ans);
+  const int *igrps = INTEGER_RO(grps), *iorder = byorder ? INTEGER_RO(order) : NULL;
+  // the groups are split into segments at every reset (a new group of the equi join columns), after which ids start again
+  // from 1 with none of the previous groups to nest in. Each segment is independent of the others, so they are done in
+  // parallel. First find where segments start, as the sequential walk did: a reset happens when a group starts at rlen
+  int *segstart = (int *)R_alloc(ngrps+1, sizeof(*segstart)), nseg = 0;
+  segstart[nseg++] = 0;
+  R_len_t resetctr=0, rlen = length(resetvals) ? INTEGER(resetvals)[0] : 0;
   for (int i=1; i<ngrps; i++) {
-    // "first"=add next grp to current grp iff min(next) >= min(current)
-    // "last"=add next grp to current grp iff max(next) >= max(current)
-    // in addition to this thisi >= previ should be satisfied
-    // could result in more groups.. so done only for first/last cases
-    // as it allows to extract indices directly in bmerge.
-    grplen = (i+1 < ngrps) ? igrps[i+1]-igrps[i] : nrows-igrps[i]+1;
-    starts = igrps[i]-1 + (mult != LAST ? 0 : grplen-1);
-    thisi = byorder ? INTEGER(order)[starts]-1 : starts;
-    Rboolean b = TRUE;
-    int k = 0;
-    for (; k<nansgrp; k++) {
-      int j = ncols;
-      previ = ansgrp[k];
-      // b=TRUE is ideal for mult=ALL, results in lesser groups
-      b = mult == ALL || (thisi >= previ);
-      // >= 0 is not necessary as first col will always be in
-      // increasing order. NOTE: all "==" cols are already skipped for
-      // computing nestedid during R-side call, for efficiency.
-      while(b && --j>0) {
-        v = VECTOR_ELT(l,INTEGER(cols)[j]-1);
-        switch(TYPEOF(v)) {
-        case INTSXP: case LGLSXP:
-          b = INTEGER(v)[thisi] >= INTEGER(v)[previ];
-          break;
-        case STRSXP :
-          b = ENC2UTF8(STRING_ELT(v,thisi)) == ENC2UTF8(STRING_ELT(v,previ));
-          break;
-        case REALSXP: {
-          double *xd = REAL(v);
-          b = i64[j] ? ((int64_t *)xd)[thisi] >= ((int64_t *)xd)[previ] :
-                       dtwiddle(xd[thisi]) >= dtwiddle(xd[previ]);
-        } break;
-        default: // # nocov
-          error(_("Type '%s' is not supported"), type2char(TYPEOF(v)));  // # nocov
-        }
-      }
-      if (b) break;
-    }
-    // TODO: move this as the outer for-loop and parallelise..
-    // but preferably wait to see if problems with that big non-equi
-    // group sizes do occur that commonly before to invest time here.
-    int tmp=0;
-    if (rlen != starts) {
-      tmp = b ? k : nansgrp++;
-    } else { // we're wrapping up this group, reset nansgrp
-      tmp = 0; nansgrp = 1;
+    const int grplen = (i+1 < ngrps) ? igrps[i+1]-igrps[i] : nrows-igrps[i]+1;
+    const int starts = igrps[i]-1 + (mult != LAST ? 0 : grplen-1);
+    if (rlen == starts) { // we're wrapping up this group, reset nansgrp
+      segstart[nseg++] = i;
       rlen += INTEGER(resetvals)[++resetctr];
     }
-    if (nansgrp >= ansgrpsize) {
-      ansgrpsize = MIN(nrows, (size_t)(1.1*(double)ansgrpsize*((double)nrows/i)));
-      ansgrp = R_Realloc(ansgrp, ansgrpsize, int);
-    }
-    for (int j=0; j<grplen; j++) {
-      ians[byorder ? INTEGER(order)[igrps[i]-1+j]-1 : igrps[i]-1+j] = tmp+1;
+  }
+  segstart[nseg] = ngrps;
+  bool failed = false;
+  #pragma omp parallel for schedule(dynamic) num_threads(getDTthreads(nseg, false))
+  for (int s=0; s<nseg; s++) {
+    if (failed) continue;
+    // one row of each group of ids so far, for the next groups to be compared to
+    int ansgrpsize = 1000, nansgrp = 0;
+    int *ansgrp = malloc(sizeof(*ansgrp) * ansgrpsize);
+    if (!ansgrp) { failed = true; continue; } // # nocov
+    for (int i=segstart[s]; i<segstart[s+1]; i++) {
+      // "first"=add next grp to current grp iff min(next) >= min(current)
+      // "last"=add next grp to current grp iff max(next) >= max(current)
+      // in addition to this thisi >= previ should be satisfied
+      // could result in more groups.. so done only for first/last cases
+      // as it allows to extract indices directly in bmerge.
+      const int grplen = (i+1 < ngrps) ? igrps[i+1]-igrps[i] : nrows-igrps[i]+1;
+      const int starts = igrps[i]-1 + (mult != LAST ? 0 : grplen-1);
+      const int thisi = byorder ? iorder[starts]-1 : starts;
+      int tmp = 0;
+      if (i == segstart[s]) { // the first group of a segment starts the ids again
+        nansgrp = 1;
+      } else {
+        bool b = true;
+        int k = 0;
+        for (; k<nansgrp; k++) {
+          int j = ncols;
+          const int previ = ansgrp[k];
+          // b=TRUE is ideal for mult=ALL, results in lesser groups
+          b = mult == ALL || (thisi >= previ);
+          // >= 0 is not necessary as first col will always be in
+          // increasing order. NOTE: all "==" cols are already skipped for
+          // computing nestedid during R-side call, for efficiency.
+          while(b && --j>0) {
+            const runcol_t *c = nc+j;
+            switch(c->type) {
+            case INTSXP: case LGLSXP:
+              b = ((const int *)c->p)[thisi] >= ((const int *)c->p)[previ];
+              break;
+            case STRSXP :
+              b = ((const SEXP *)c->p)[thisi] == ((const SEXP *)c->p)[previ];
+              break;
+            default: { // REALSXP
+              const double *xd = (const double *)c->p;
+              b = !c->twiddle ? ((const int64_t *)xd)[thisi] >= ((const int64_t *)xd)[previ] :
+                                dtwiddle(xd[thisi]) >= dtwiddle(xd[previ]);
+            }
+            }
+          }
+          if (b) break;
+        }
+        tmp = b ? k : nansgrp++;
+      }
+      if (nansgrp >= ansgrpsize) {
+        ansgrpsize = MIN(nrows, 2*ansgrpsize);
+        int *tt = realloc(ansgrp, sizeof(*ansgrp) * ansgrpsize);
+        if (!tt) { failed = true; break; } // # nocov
+        ansgrp = tt;
+      }
+      for (int j=0; j<grplen; j++) {
+        ians[byorder ? iorder[igrps[i]-1+j]-1 : igrps[i]-1+j] = tmp+1;
+      }
+      ansgrp[tmp] = thisi;
     }
-    ansgrp[tmp] = thisi;
+    free(ansgrp);
   }
-  R_Free(ansgrp);
-  UNPROTECT(1);
+  if (failed) error(_("Unable to allocate working memory for non-equi join group ids")); // # nocov
+  UNPROTECT(2);
   return(ans);
 }
 
@@ -376,3 +350,278 @@ SEXP uniqueNlogical(SEXP x, SEXP narmArg) {
     return ScalarInteger(3-narm);
   return ScalarInteger(2-(narm && third!=NA_LOGICAL));
 }
+
+// 64-bit key of a double such that values uniqueN() considers equal have equal keys: -0.0 and 0.0 are the same, while
+// NA and NaN are distinct from each other and from all other values
+uint64_t uniqueNdkey(double x)
+{
+  union {
+    double d;
+    uint64_t u64;
+  } u;
+  if (ISNAN(x)) return ISNA(x) ? 0x7ff00000000007a2 : 0x7ff8000000000000;  // normalise payloads, as dtwiddle does
+  u.d = x==0 ? 0 : x;
+  return u.u64;
+}
+
+// splitmix64 finaliser, which spreads every bit of a key over all bits of the hash
+static inline uint64_t mix64(uint64_t h)
+{
+  h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+// HyperLogLog (Flajolet et al. 2007) for uniqueN(approx=TRUE): each key is hashed (splitmix64 finaliser) and the
+// register selected by the top HLL_P bits of the hash keeps the maximum position of the first set bit in the rest
+void hlladd(uint8_t *reg, uint64_t key)
+{
+  const uint64_t h = mix64(key);
+  const int idx = (int)(h >> (64-HLL_P));
+  uint64_t w = h << HLL_P;
+  uint8_t rho = 1;
+  while (rho <= 64-HLL_P && !(w & 0x8000000000000000ULL)) { rho++; w <<= 1; }
+  if (rho > reg[idx]) reg[idx] = rho;
+}
+
+double hllestimate(const uint8_t *reg)
+{
+  const double m = HLL_REGISTERS, alpha = 0.7213/(1.0 + 1.079/m);
+  double sum = 0.0;
+  int zeros = 0;
+  for (int j=0; j<HLL_REGISTERS; ++j) {
+    sum += ldexp(1.0, -reg[j]);
+    zeros += reg[j]==0;
+  }
+  const double E = alpha*m*m/sum;
+  // small range correction (linear counting); no large range correction is needed with a 64-bit hash
+  return (E <= 2.5*m && zeros) ? m*log(m/zeros) : E;
+}
+
+SEXP uniqueNapprox(SEXP x, SEXP narmArg)
+{
+  if (!isVectorAtomic(x)) error(_("x is not an atomic vector"));
+  if (!IS_TRUE_OR_FALSE(narmArg))
+    error(_("%s must be TRUE or FALSE"), "na.rm");
+  const bool narm = LOGICAL(narmArg)[0];
+  const int64_t n = xlength(x);
+  if (n==0) return ScalarInteger(0);
+  if (TYPEOF(x)!=LGLSXP && TYPEOF(x)!=INTSXP && TYPEOF(x)!=REALSXP && TYPEOF(x)!=STRSXP)
+    error(_("Type '%s' is not supported by uniqueN(approx=TRUE)"), type2char(TYPEOF(x)));
+  // pointer equality is string equality after any non-UTF-8 strings are translated, as in chmatch. Done before reg is
+  // allocated as it may raise an R error
+  x = PROTECT(TYPEOF(x)==STRSXP ? coerceUtf8IfNeeded(x) : x);
+  int nth = getDTthreads(n, true);
+  uint8_t *reg = calloc((size_t)nth*HLL_REGISTERS, sizeof(*reg));  // one set of registers per thread, merged by max afterwards
+  if (!reg) error(_("Unable to allocate %d * %d bytes for uniqueN(approx=TRUE)"), nth, HLL_REGISTERS); // # nocov
+  switch(TYPEOF(x)) {
+  case LGLSXP: case INTSXP: {
+    const int *xd = INTEGER(x);
+    #pragma omp parallel for num_threads(nth)
+    for (int64_t i=0; i<n; ++i) {
+      if (narm && xd[i]==NA_INTEGER) continue;
+      hlladd(reg + omp_get_thread_num()*HLL_REGISTERS, (uint64_t)(uint32_t)xd[i]);
+    }
+  } break;
+  case REALSXP: {
+    const bool isInt64 = INHERITS(x, char_integer64);
+    const double *xd = REAL(x);
+    const int64_t *xi64 = (const int64_t *)REAL(x);
+    #pragma omp parallel for num_threads(nth)
+    for (int64_t i=0; i<n; ++i) {
+      if (narm && (isInt64 ? xi64[i]==NA_INTEGER64 : ISNAN(xd[i]))) continue;
+      hlladd(reg + omp_get_thread_num()*HLL_REGISTERS, isInt64 ? (uint64_t)xi64[i] : uniqueNdkey(xd[i]));
+    }
+  } break;
+  case STRSXP: {
+    const SEXP *xd = STRING_PTR_RO(x);
+    #pragma omp parallel for num_threads(nth)
+    for (int64_t i=0; i<n; ++i) {
+      if (narm && xd[i]==NA_STRING) continue;
+      hlladd(reg + omp_get_thread_num()*HLL_REGISTERS, (uint64_t)(uintptr_t)xd[i]);
+    }
+  } break;
+  default:
+    free(reg); // # nocov
+    internal_error(__func__, "type '%s' not caught earlier", type2char(TYPEOF(x))); // # nocov
+  }
+  for (int t=1; t<nth; ++t) {
+    const uint8_t *treg = reg + t*HLL_REGISTERS;
+    for (int j=0; j<HLL_REGISTERS; ++j) if (treg[j] > reg[j]) reg[j] = treg[j];
+  }
+  const double E = hllestimate(reg);
+  free(reg);
+  UNPROTECT(1);
+  return ScalarInteger(E >= INT_MAX ? INT_MAX : (int)nearbyint(E));
+}
+
+/* Distinct rows by hashing, for duplicated(), unique() and uniqueN() when no sort is needed
+ *   1) the key of each row is hashed, in parallel over rows
+ *   2) rows are scattered to partitions by the top bits of their hash, in parallel over chunks of rows, keeping row
+ *      order within each partition
+ *   3) each partition is deduplicated with its own open addressing table, in parallel over partitions, so no table is
+ *      shared between threads. The first row (last when fromLast) of each distinct key is marked
+ * Keys are equal as in forder without rounding: -0.0 and 0.0 are the same, NA and NaN differ, and strings are compared by
+ * address after any non-UTF-8 strings are translated, as in chmatch
+ */
+
+typedef struct {
+  SEXPTYPE type;
+  bool int64;
+  const void *p;
+} hcol_t;
+
+static inline uint64_t hkey(const hcol_t *c, int64_t i, bool imag)
+{
+  switch (c->type) {
+  case LGLSXP : case INTSXP : return (uint64_t)(uint32_t)((const int *)c->p)[i];
+  case REALSXP : return c->int64 ? (uint64_t)((const int64_t *)c->p)[i] : uniqueNdkey(((const double *)c->p)[i]);
+  case CPLXSXP : return uniqueNdkey(imag ? ((const Rcomplex *)c->p)[i].i : ((const Rcomplex *)c->p)[i].r);
+  default : return (uint64_t)(uintptr_t)((const SEXP *)c->p)[i]; // STRSXP
+  }
+}
+
+static inline bool hisna(const hcol_t *c, int64_t i)
+{
+  switch (c->type) {
+  case LGLSXP : case INTSXP : return ((const int *)c->p)[i] == NA_INTEGER;
+  case REALSXP : return c->int64 ? ((const int64_t *)c->p)[i] == NA_INTEGER64 : ISNAN(((const double *)c->p)[i]);
+  case CPLXSXP : return ISNAN(((const Rcomplex *)c->p)[i].r) || ISNAN(((const Rcomplex *)c->p)[i].i);
+  default : return ((const SEXP *)c->p)[i] == NA_STRING;
+  }
+}
+
+static inline bool hrowequal(const hcol_t *hc, int ncol, int64_t a, int64_t b)
+{
+  for (int j=0; j<ncol; ++j) {
+    if (hkey(hc+j, a, false) != hkey(hc+j, b, false)) return false;
+    if (hc[j].type==CPLXSXP && hkey(hc+j, a, true) != hkey(hc+j, b, true)) return false;
+  }
+  return true;
+}
+
+// ret is "duplicated" (logical), "unique" (1-based rows of the first occurrences, in row order) or "uniqueN" (count)
+SEXP hashuniq(SEXP l, SEXP cols, SEXP fromLastArg, SEXP narmArg, SEXP retArg)
+{
+  if (!isNewList(l)) internal_error(__func__, "l is not a list of columns"); // # nocov
+  if (!isInteger(cols) || !LENGTH(cols)) internal_error(__func__, "cols must be a non-empty integer vector"); // # nocov
+  if (!IS_TRUE_OR_FALSE(fromLastArg))
+    error(_("%s must be TRUE or FALSE"), "fromLast");
+  if (!IS_TRUE_OR_FALSE(narmArg))
+    error(_("%s must be TRUE or FALSE"), "na.rm");
+  if (!isString(retArg) || LENGTH(retArg)!=1) internal_error(__func__, "ret must be a single string"); // # nocov
+  const bool fromLast = LOGICAL(fromLastArg)[0], narm = LOGICAL(narmArg)[0];
+  const char *ret = CHAR(STRING_ELT(retArg, 0));
+  const int ncol = LENGTH(cols), *icols = INTEGER(cols);
+  for (int j=0; j<ncol; ++j) {
+    if (icols[j] < 1 || icols[j] > LENGTH(l)) internal_error(__func__, "cols[%d]=%d is out of range [1,ncol(l)=%d]", j+1, icols[j], LENGTH(l)); // # nocov
+  }
+  const int64_t n = xlength(VECTOR_ELT(l, icols[0]-1));
+  SEXP utf8 = PROTECT(allocVector(VECSXP, ncol));  // character columns with every string UTF-8
+  hcol_t *hc = (hcol_t *)R_alloc(ncol, sizeof(*hc));
+  for (int j=0; j<ncol; ++j) {
+    SEXP col = VECTOR_ELT(l, icols[j]-1);
+    if (xlength(col) != n) internal_error(__func__, "column %d is length %"PRId64" but column 1 is length %"PRId64, j+1, (int64_t)xlength(col), n); // # nocov
+    hc[j] = (hcol_t){ .type=TYPEOF(col), .int64=INHERITS(col, char_integer64), .p=NULL };
+    switch (TYPEOF(col)) {
+    case LGLSXP : case INTSXP : case REALSXP : case CPLXSXP :
+      hc[j].p = DATAPTR_RO(col);
+      break;
+    case STRSXP :
+      SET_VECTOR_ELT(utf8, j, col = coerceUtf8IfNeeded(col));
+      hc[j].p = STRING_PTR_RO(col);
+      break;
+    default :
+      internal_error(__func__, "type '%s' should have been sorted rather than hashed", type2char(TYPEOF(col))); // # nocov
+    }
+  }
+  int nth = getDTthreads(n, true);
+  // about 64 partitions per thread so that their sizes even out with dynamic scheduling, fewer when there are few rows
+  int pbits = 0;
+  while (pbits < 12 && (1<<pbits) < nth*64 && ((int64_t)1<<pbits)*4096 < n) pbits++;
+  const int npart = 1<<pbits, nchunk = nth;
+  uint64_t *h = (uint64_t *)R_alloc(n, sizeof(*h));
+  int *idx = (int *)R_alloc(n, sizeof(*idx));
+  int8_t *flag = (int8_t *)R_alloc(n, sizeof(*flag));  // 1 for the first row of its key, 0 for a duplicate, -1 for a row skipped by na.rm
+  int64_t *pos = (int64_t *)R_alloc((size_t)nchunk*npart, sizeof(*pos));
+  memset(pos, 0, (size_t)nchunk*npart*sizeof(*pos));
+  #pragma omp parallel for num_threads(nth)
+  for (int c=0; c<nchunk; ++c) {
+    const int64_t from = n*c/nchunk, to = n*(c+1)/nchunk;
+    int64_t *cnt = pos + (size_t)c*npart;
+    for (int64_t i=from; i<to; ++i) {
+      bool na = false;
+      uint64_t v = 0x9E3779B97F4A7C15ULL;
+      for (int j=0; j<ncol; ++j) {
+        if (narm) na |= hisna(hc+j, i);
+        v = mix64(v ^ hkey(hc+j, i, false));
+        if (hc[j].type==CPLXSXP) v = mix64(v ^ hkey(hc+j, i, true));
+      }
+      h[i] = v;
+      flag[i] = na ? -1 : 0;
+      cnt[pbits ? v>>(64-pbits) : 0]++;
+    }
+  }
+  // rows of partition p go after all rows of the partitions before it, and after the rows of p in the chunks before
+  for (int64_t p=0, sum=0; p<npart; ++p) {
+    for (int c=0; c<nchunk; ++c) {
+      const int64_t tt = pos[(size_t)c*npart+p];
+      pos[(size_t)c*npart+p] = sum;
+      sum += tt;
+    }
+  }
+  int64_t *partstart = (int64_t *)R_alloc(npart+1, sizeof(*partstart));
+  for (int p=0; p<npart; ++p) partstart[p] = pos[p];  // chunk 0 of each partition
+  partstart[npart] = n;
+  #pragma omp parallel for num_threads(nth)
+  for (int c=0; c<nchunk; ++c) {
+    const int64_t from = n*c/nchunk, to = n*(c+1)/nchunk;
+    int64_t *next = pos + (size_t)c*npart;
+    for (int64_t i=from; i<to; ++i) idx[next[pbits ? h[i]>>(64-pbits) : 0]++] = (int)i;
+  }
+  bool failed = false;
+  #pragma omp parallel for schedule(dynamic) num_threads(nth)
+  for (int p=0; p<npart; ++p) {
+    const int64_t from = partstart[p], m = partstart[p+1]-from;
+    if (!m || failed) continue;
+    size_t size = 16;
+    while (size < 2*(size_t)m) size *= 2;
+    const size_t mask = size-1;
+    int *tab = calloc(size, sizeof(*tab));  // row+1 of the first row of each key seen so far, 0 for an empty slot
+    if (!tab) { failed = true; continue; } // # nocov
+    for (int64_t k=0; k<m; ++k) {
+      const int i = idx[fromLast ? from+m-1-k : from+k];
+      if (flag[i] < 0) continue;
+      size_t slot = h[i] & mask;  // the top bits selected the partition, so the low bits place the row in it
+      bool seen = false;
+      while (tab[slot]) {
+        const int r = tab[slot]-1;
+        if (h[r]==h[i] && hrowequal(hc, ncol, r, i)) { seen = true; break; }
+        slot = (slot+1) & mask;
+      }
+      if (!seen) {
+        tab[slot] = i+1;
+        flag[i] = 1;
+      }
+    }
+    free(tab);
+  }
+  if (failed)
+    error(_("Unable to allocate working memory for %"PRId64" rows to find their distinct values"), n); // # nocov
+  int64_t nuniq = 0;
+  for (int64_t i=0; i<n; ++i) nuniq += flag[i]==1;
+  SEXP ans;
+  if (!strcmp(ret, "duplicated")) {
+    ans = PROTECT(allocVector(LGLSXP, n));
+    int *ansd = LOGICAL(ans);
+    for (int64_t i=0; i<n; ++i) ansd[i] = flag[i]!=1;
+  } else if (!strcmp(ret, "unique")) {
+    ans = PROTECT(allocVector(INTSXP, nuniq));
+    int *ansd = INTEGER(ans);
+    for (int64_t i=0, k=0; i<n; ++i) if (flag[i]==1) ansd[k++] = (int)i+1;
+  } else {
+    ans = PROTECT(ScalarInteger((int)nuniq));
+  }
+  UNPROTECT(2);
+  return ans;
+}